@@ -4,6 +4,15 @@
 
 // Actor abstract class common functions
 //
+Actor::Actor(StudentWorld* world, int iid, int x, int y, int dir, int depth, double size, bool blocking, bool damagable,
+	bool player, bool playerTarget)
+	: GraphObject(iid, x, y, DIRECTION_RIGHT, depth, size, &world->getRenderRegistry()),
+	m_world(world), m_sequence(world->newActorSequence()), m_player(player), m_playerTarget(playerTarget),
+	m_blocking(blocking), m_damagable(damagable), m_alive(ALIVE)
+{
+	setDirection(dir);
+}
+
 bool Actor::isOverlappingSpace(double x, double y, double width, double height) const
 {
 	double x1 = getX();
@@ -21,6 +30,39 @@ bool Actor::isOverlappingSpace(double x, double y, double width, double height)
 	return true;
 }
 
+void Actor::moveTo(double x, double y)
+{
+	double oldX = getX();
+	double oldY = getY();
+	GraphObject::moveTo(x, y);
+	getWorld()->actorMoved(this, oldX, oldY);
+}
+
+void Actor::setAlive(bool alive)
+{
+	// the world queues each death once, removal waits until the end of the tick
+	if (m_alive && !alive)
+	{
+		getWorld()->actorDied(this);
+	}
+	m_alive = alive;
+}
+
+bool Actor::bonk(Actor* actor)
+{
+	return getWorld()->bonk(this, actor);
+}
+
+bool Actor::damage(Actor* actor)
+{
+	return getWorld()->damage(this, actor);
+}
+
+int Actor::randInt(int min, int max)
+{
+	return getWorld()->getRandom().randInt(m_sequence, m_randomDraws++, min, max);
+}
+
 void Actor::reverseDirection() 
 {
 	int direction = (getDirection() == DIRECTION_LEFT) ? DIRECTION_RIGHT : DIRECTION_LEFT;
@@ -32,7 +74,7 @@ void Actor::setDirection(int direction)
 	int graphDirection;
 	if (direction == DIRECTION_RANDOM) 
 	{
-		graphDirection = ((rand() % 2) == 0) ? DIRECTION_LEFT : DIRECTION_RIGHT;
+		graphDirection = (randInt(0, 1) == 0) ? DIRECTION_LEFT : DIRECTION_RIGHT;
 	}
 	else 
 	{
@@ -89,16 +131,18 @@ bool Actor::doFalling(int steps, int moveSteps, bool mustMove)
 {
 	double x = getX();
 	double y = getY();
-	if (getWorld()->isSpaceUnderActorAt(this, x, y, SPRITE_WIDTH, steps))
+	moveSteps = abs(moveSteps);
+	if (getDirection() == DIRECTION_LEFT)
+	{
+		moveSteps = -moveSteps;
+	}
+	// one sweep answers the floor test, the sideways test and the move
+	StudentWorld::Sweep& sweep = getWorld()->sweepActor(this, moveSteps, -steps);
+	if (sweep.isSpaceUnder(x, y, SPRITE_WIDTH, steps))
 	{
 		if (moveSteps != 0) 
 		{
-			moveSteps = abs(moveSteps);
-			if (getDirection() == DIRECTION_LEFT)
-			{
-				moveSteps = -moveSteps;
-			}
-			if (getWorld()->anyOtherBlockingActorsAt(this, x + moveSteps, y - steps))
+			if (sweep.isBlockedAt(x + moveSteps, y - steps, SPRITE_WIDTH, SPRITE_HEIGHT))
 			{
 				if (mustMove) 
 				{
@@ -107,7 +151,7 @@ bool Actor::doFalling(int steps, int moveSteps, bool mustMove)
 				moveSteps = 0;
 			}
 		}
-		return getWorld()->moveActor(this, x + moveSteps, y - steps);
+		return sweep.moveTo(x + moveSteps, y - steps);
 	}
 	return false;
 }
@@ -153,13 +197,24 @@ void PeachActor::doShootRecharging()
 	}
 }
 
-bool PeachActor::bonk(Actor* actor)
+void PeachActor::saveState(SnapshotWriter& writer) const
 {
-	if (!actor->isAlive())
-	{
-		return false;
-	}
-	return actor->bonkedBy(this);
+	writer.putI32(m_starPowerTicks);
+	writer.putU8(m_tempInvincibilityTicks);
+	writer.putU8(m_shootRechargingTicks);
+	writer.putBool(m_shootPower);
+	writer.putBool(m_jumpPower);
+	writer.putI16(m_hitPoints);
+}
+
+void PeachActor::loadState(SnapshotReader& reader)
+{
+	m_starPowerTicks = reader.getI32();
+	m_tempInvincibilityTicks = reader.getU8();
+	m_shootRechargingTicks = reader.getU8();
+	m_shootPower = reader.getBool();
+	m_jumpPower = reader.getBool();
+	m_hitPoints = reader.getI16();
 }
 
 bool PeachActor::bonkedBy(Actor* actor)
@@ -224,7 +279,7 @@ bool PeachActor::doUserInput()
 				{
 					x += (FIREBALL_START_DISTANCE);
 				}
-				getWorld()->addActor(new PeachFireballActor(getWorld(), x, (int)getY(), getDirection()));
+				getWorld()->spawnActor<PeachFireballActor>(x, (int)getY(), getDirection());
 			}
 			didSomething = true;
 			break;
@@ -235,17 +290,9 @@ bool PeachActor::doUserInput()
 
 // PLAYER TARGET abstract actor
 //
-void PlayerTargetActor::doSomething() 
+void PlayerTargetActor::playerInside(PeachActor* peach, unsigned volumes)
 {
-	if (!isAlive())
-	{
-		return;
-	}
-	PlayerActor* player = getWorld()->getPlayer();
-	if (isOverlapping(player))
-	{
-		doPlayerTargetAction(player);
-	}
+	doPlayerTargetAction(peach);
 }
 
 // FLAG PLAYER TARGET ACTOR
@@ -268,13 +315,13 @@ void MarioPlayerTargetActor::doPlayerTargetAction(PlayerActor* player)
 
 // OBSTACLE ACTOR
 //
-bool ObstacleActor::bonkedBy(Actor* actor)
+bool ObstacleActor::obstacleBonkedBy(StudentWorld* world, Actor* actor)
 {
-	if (actor != getWorld()->getPlayer())
+	if (actor != world->getPlayer())
 	{
 		return false;
 	}
-	getWorld()->playSound(SOUND_PLAYER_BONK);
+	world->playSound(SOUND_PLAYER_BONK);
 	return true;
 }
 
@@ -290,8 +337,7 @@ bool GoodieBlockActor::bonkedBy(Actor* actor)
 	{
 		useItem();
 		StudentWorld* world = getWorld();
-		Actor* goodie = createGoodie(world, (int)getX(), (int)(getY() + SPRITE_HEIGHT));
-		world->addActor(goodie);
+		createGoodie(world, (int)getX(), (int)(getY() + SPRITE_HEIGHT));
 		world->playSound(SOUND_POWERUP_APPEARS);
 	}
 	else
@@ -303,15 +349,15 @@ bool GoodieBlockActor::bonkedBy(Actor* actor)
 
 // STAR GOODIE BLOCK Actor
 //
-Actor* StarGoodieBlockActor::createGoodie(StudentWorld* world, int x, int y) { return new StarGoodieActor(world, x, y); }
+Actor* StarGoodieBlockActor::createGoodie(StudentWorld* world, int x, int y) { return world->spawnActor<StarGoodieActor>(x, y); }
 
 // FLOWER GOODIE BLOCK Actor
 //
-Actor* FlowerGoodieBlockActor::createGoodie(StudentWorld* world, int x, int y) { return new FlowerGoodieActor(world, x, y); }
+Actor* FlowerGoodieBlockActor::createGoodie(StudentWorld* world, int x, int y) { return world->spawnActor<FlowerGoodieActor>(x, y); }
 
 // MUSHROOM GOODIE BLOCK Actor
 //
-Actor* MushroomGoodieBlockActor::createGoodie(StudentWorld* world, int x, int y) { return new MushroomGoodieActor(world, x, y); }
+Actor* MushroomGoodieBlockActor::createGoodie(StudentWorld* world, int x, int y) { return world->spawnActor<MushroomGoodieActor>(x, y); }
 
 // GOODIE Actor abstract class
 //
@@ -328,12 +374,13 @@ bool GoodieActor::doMove()
 	{
 		x += MOVE_STEPS;
 	}
-	if (getWorld()->anyOtherBlockingActorsAt(this, x, y))
+	StudentWorld::Sweep& sweep = getWorld()->sweepActor(this, x - getX(), 0);
+	if (sweep.isBlockedAt(x, y, SPRITE_WIDTH, SPRITE_HEIGHT))
 	{
 		reverseDirection();
 		return false;
 	}
-	return getWorld()->moveActor(this, x, y);
+	return sweep.moveTo(x, y);
 }
 
 void GoodieActor::finishPowerUp() 
@@ -342,18 +389,18 @@ void GoodieActor::finishPowerUp()
 	getWorld()->playSound(SOUND_PLAYER_POWERUP);
 }
 
+void GoodieActor::playerInside(PeachActor* peach, unsigned volumes)
+{
+	giveGoodiesTo(peach);
+	finishPowerUp();
+}
+
 void GoodieActor::doSomething() 
 {
 	if (!isAlive())
 	{
 		return;
 	}
-	PeachActor* peach = getWorld()->getPlayer();
-	if (isOverlapping(peach))
-	{
-		giveGoodiesTo(peach);
-		finishPowerUp();
-	}
 	doMove();
 }
 
@@ -385,15 +432,6 @@ void StarGoodieActor::giveGoodiesTo(PeachActor* peach)
 
 // ENEMY ACTOR abstract class
 //
-bool EnemyActor::bonk(Actor* actor) 
-{
-	if (!actor->isAlive())
-	{
-		return false;
-	}
-	return actor->bonkedBy(this);
-}
-
 bool EnemyActor::bonkedBy(Actor* actor) 
 {
 	PeachActor* peach = getWorld()->getPlayer();
@@ -440,15 +478,16 @@ bool EnemyActor::doMove()
 		x += MOVE_STEPS;
 		dx = x + SPRITE_WIDTH;
 	}
-	if (getWorld()->anyOtherBlockingActorsAt(this, x, y)) 
+	StudentWorld::Sweep& sweep = getWorld()->sweepActor(this, x - getX(), 0);
+	if (sweep.isBlockedAt(x, y, SPRITE_WIDTH, SPRITE_HEIGHT)) 
 	{
 		reverseDirection();
 	}
-	else if (getWorld()->isSpaceUnderActorAt(this, dx, y, 1, 1)) 
+	else if (sweep.isSpaceUnder(dx, y, 1, 1)) 
 	{
 		reverseDirection();
 	}
-	return getWorld()->moveActor(this, x, y);
+	return sweep.moveTo(x, y);
 }
 
 // GOOMBA Actor
@@ -484,7 +523,7 @@ bool KoopaEnemyActor::bonkedBy(Actor* actor)
 	{
 		return false;
 	}
-	getWorld()->addActor(new ShellActor(getWorld(), (int)getX(), (int)getY(), getDirection()));
+	getWorld()->spawnActor<ShellActor>((int)getX(), (int)getY(), getDirection());
 	return true;
 }
 
@@ -494,7 +533,7 @@ bool KoopaEnemyActor::damagedBy(Actor* actor)
 	{
 		return false;
 	}
-	getWorld()->addActor(new ShellActor(getWorld(), (int)getX(), (int)getY(), getDirection()));
+	getWorld()->spawnActor<ShellActor>((int)getX(), (int)getY(), getDirection());
 	return true;
 }
 
@@ -506,15 +545,18 @@ void PiranhaEnemyActor::doSomething()
 		return;
 	}
 	increaseAnimationNumber();
+	bool playerInSight = m_playerInSight;
+	m_playerInSight = false;
 	PeachActor* peach = getWorld()->getPlayer();
 	if (doBonkIfOverlapping(peach))
 	{
 		return;
 	}
-	if (!doTurnTowards(peach)) 
+	if (!playerInSight) 
 	{
 		return;
 	}
+	doTurnTowards(peach);
 	doFireAt(peach);
 }
 
@@ -534,24 +576,15 @@ bool PiranhaEnemyActor::doFireAt(Actor* actor)
 		}
 		m_firingDelay = FIRING_DELAY;
 		getWorld()->playSound(SOUND_PIRANHA_FIRE);
-		getWorld()->addActor(new PiranhaFireballActor(getWorld(), (int)getX(), (int)getY(), getDirection()));
+		getWorld()->spawnActor<PiranhaFireballActor>((int)getX(), (int)getY(), getDirection());
 	}
 	return true;
 }
 
-bool PiranhaEnemyActor::doTurnTowards(Actor* actor)
+void PiranhaEnemyActor::doTurnTowards(Actor* actor)
 {
-	if (actor->getY() < (getY() - DETECTION_HEIGHT))
-	{
-		return false;
-	}
-	if (actor->getY() >= (getY() + DETECTION_HEIGHT))
-	{
-		return false;
-	}
 	int actorDirection = (actor->getX() < getX()) ? DIRECTION_LEFT : DIRECTION_RIGHT;
 	setDirection(actorDirection);
-	return true;
 }
 
 // TEMPORARY Actor common functions
@@ -569,35 +602,26 @@ bool TemporaryActor::doMove()
 	{
 		x += MOVE_STEPS;
 	}
-	if (getWorld()->anyOtherBlockingActorsAt(this, x, y))
+	StudentWorld::Sweep& sweep = getWorld()->sweepActor(this, x - getX(), 0);
+	if (sweep.isBlockedAt(x, y, SPRITE_WIDTH, SPRITE_HEIGHT))
 	{
 		setAlive(!ALIVE);
 		return false;
 	}
-	return getWorld()->moveActor(this, x, y);
+	return sweep.moveTo(x, y);
 }
 
-void PiranhaFireballActor::doSomething()
+void PiranhaFireballActor::playerInside(PeachActor* peach, unsigned volumes)
 {
-	PeachActor* peach = getWorld()->getPlayer();
-	if (isOverlapping(peach))
+	if (damage(peach))
 	{
-		if (damage(peach))
-		{
-			setAlive(!ALIVE);
-			return;
-		}
+		setAlive(!ALIVE);
 	}
-	doMove();
 }
 
-bool PiranhaFireballActor::damage(Actor* actor)
+void PiranhaFireballActor::doSomething()
 {
-	if (!actor->isAlive()) 
-	{
-		return false;
-	}
-	return actor->damagedBy(this);
+	doMove();
 }
 
 void PeachFireballActor::doSomething()
@@ -610,13 +634,9 @@ void PeachFireballActor::doSomething()
 	doMove();
 }
 
-bool PeachFireballActor::damage(Actor* actor) 
+bool PeachFireballActor::canDamage(Actor* actor) 
 {
-	if (getWorld()->getPlayer() == actor) 
-	{
-		return false;
-	}
-	return actor->damagedBy(this);
+	return getWorld()->getPlayer() != actor;
 }
 
 void ShellActor::doSomething()
@@ -629,15 +649,11 @@ void ShellActor::doSomething()
 	doMove();
 }
 
-bool ShellActor::damage(Actor* actor)
+bool ShellActor::canDamage(Actor* actor)
 {
 	if (!actor->isAlive())
 	{
 		return false;
 	}
-	if (getWorld()->getPlayer() == actor)
-	{
-		return false;
-	}
-	return actor->damagedBy(this);
+	return getWorld()->getPlayer() != actor;
 }
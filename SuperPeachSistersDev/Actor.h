@@ -3,6 +3,9 @@
 
 #include "GraphObject.h"
 #include "GameConstants.h"
+#include "ActorKind.h"
+#include "ActorSlotMap.h"
+#include "WorldSnapshot.h"
 #include "StudentWorld.h"
 
 // Students:  Add code to this file, Actor.cpp, StudentWorld.h, and StudentWorld.cpp
@@ -61,23 +64,48 @@ class Actor : public GraphObject
 {
 public:
 	Actor(StudentWorld* world, int iid, int x, int y, int dir, int depth, double size, bool blocking, bool damagable,
-		bool player = !PLAYER, bool playerTarget = !PLAYER_TARGET)
-		: GraphObject(iid, x, y, DIRECTION_RIGHT, depth, size),
-		m_world(world), m_blocking(blocking), m_damagable(damagable), m_player(player), m_playerTarget(playerTarget),
-		m_alive(ALIVE)
-	{ 
-		setDirection(dir);
-	}
+		bool player = !PLAYER, bool playerTarget = !PLAYER_TARGET);
 
 	virtual void doSomething() = 0;
-	virtual bool bonk(Actor* actor) { return false; }
 	virtual bool bonkedBy(Actor* actor) { return false; }
-	virtual bool damage(Actor* actor) { return false; }
 	virtual bool damagedBy(Actor* actor) { return false; }
 
+	// bonk and damage go through the world's interaction tables, keyed by the kinds of both actors; the tables
+	// call the statically resolved canBonk/canDamage of this actor's class and bonkedBy/damagedBy of the other's
+	bool bonk(Actor* actor);
+	bool damage(Actor* actor);
+	bool canBonk(Actor* actor) { return false; }
+	bool canDamage(Actor* actor) { return false; }
+	ActorKind getKind() const { return m_kind; }
+
+	// Each class names its collision category, its observation channel and the categories its bonks and damage
+	// can have any effect on
+	static const unsigned BONK_MASK = CATEGORY_NONE;
+	static const unsigned DAMAGE_MASK = CATEGORY_NONE;
+	unsigned getCategory() const { return m_category; }
+
+	// Terrain with nothing of its own to remember: a world sharing its level's terrain never builds it, and the
+	// world stands in for it when bonked (see ObstacleActor::obstacleBonkedBy)
+	static const bool STATELESS_TERRAIN = false;
+
+	// Sensors name the trigger volumes they register; the world calls them back, resolved statically like bonks,
+	// on the tick the player first enters one of the volumes and on every tick the player is inside any of them
+	static const unsigned TRIGGER_VOLUMES = TRIGGER_NONE;
+	static constexpr double SIGHT_HEIGHT = 0;
+	void playerEntered(PeachActor* peach, unsigned volumes) { }
+	void playerInside(PeachActor* peach, unsigned volumes) { }
+
+	// Classes with state beyond what every actor has write and read it for world snapshots, resolved statically
+	// like bonks; what a class writes it must read back in the same order
+	void saveState(SnapshotWriter& writer) const { }
+	void loadState(SnapshotReader& reader) { }
+
 	bool isOverlappingSpace(double x, double y, double width, double height) const;
 	bool isOverlapping(Actor* actor) const { return isOverlappingSpace(actor->getX(), actor->getY(), SPRITE_WIDTH, SPRITE_HEIGHT); };
 
+	// Inert actors have nothing to do each tick, so the world leaves them out of its active set
+	virtual bool isInert() const { return false; }
+
 	bool isDamagable() const { return m_damagable; }
 	bool isBlocking() const { return m_blocking; }
 	bool isAlive() const { return m_alive; }
@@ -86,11 +114,17 @@ public:
 	bool isPlayerTarget() { return m_playerTarget; }
 	virtual void targetAction(Actor* actor) { }
 
+	void moveTo(double x, double y);
+	unsigned int getSequence() const { return m_sequence; }
+	ActorHandle getHandle() const { return m_handle; }
+
 protected:
 	StudentWorld* getWorld() { return m_world; }
 	void reverseDirection();
 	void setDirection(int direction);
-	void setAlive(bool alive) { m_alive = alive; }
+	void setAlive(bool alive);
+	// Uniform int from min to max, inclusive, drawn from the world's generator under this actor's own key and count
+	int randInt(int min, int max);
 
 	bool move(int steps);
 	bool jump(int distance);
@@ -98,7 +132,18 @@ protected:
 	bool doFalling(int steps, int moveSteps = 0, bool mustMove = false);
 
 private:
+	friend class StudentWorld;
 	StudentWorld* m_world;
+	unsigned int m_sequence = 0;
+	unsigned int m_randomDraws = 0;
+	ActorHandle m_handle;
+	ActorKind m_kind = KIND_COUNT;
+	unsigned m_category = CATEGORY_NONE;
+	unsigned m_playerInside = TRIGGER_NONE;
+	bool m_pooled = false;
+	bool m_active = false;
+	bool m_stateChanged = false;
+	uint64_t m_stateHash = 0;
 	bool m_player;
 	bool m_playerTarget;
 
@@ -125,8 +170,12 @@ class PeachActor : public PlayerActor {
 public:
 	PeachActor(StudentWorld* world, int x, int y) 
 		: PlayerActor(world, IID_PEACH, x, y, DIRECTION_RIGHT, DEPTH_BOTTOM, DEFAULT_SIZE, !BLOCKING, DAMAGABLE) { }
+	static const ActorKind KIND = KIND_PEACH;
+	static const unsigned CATEGORY = CATEGORY_PLAYER;
+	static const ObservationChannel OBSERVATION_CHANNEL = CHANNEL_PEACH;
+	static const unsigned BONK_MASK = CATEGORY_ENEMY | CATEGORY_TERRAIN;
 	void doSomething();
-	bool bonk(Actor* actor);
+	bool canBonk(Actor* actor) { return actor->isAlive(); }
 	bool bonkedBy(Actor* actor);
 	bool damagedBy(Actor* actor) { return bonkedBy(actor); }
 
@@ -139,6 +188,10 @@ public:
 	bool hasJumpPower() { return m_jumpPower; }
 	bool hasShootPower() { return m_shootPower; }
 	bool hasInvincibility() { return m_tempInvincibilityTicks > 0; }
+	int getHitPoints() const { return m_hitPoints; }
+
+	void saveState(SnapshotWriter& writer) const;
+	void loadState(SnapshotReader& reader);
 
 private:
 	bool doUserInput();
@@ -171,7 +224,12 @@ class PlayerTargetActor : public Actor {
 public:
 	PlayerTargetActor(StudentWorld* world, int iid, int x, int y, int direction, int depth, double size, bool blocking, bool damagable)
 		: Actor(world, iid, x, y, direction, depth, size, blocking, damagable) { }
-	void doSomething();
+	static const unsigned CATEGORY = CATEGORY_TRIGGER;
+	static const ObservationChannel OBSERVATION_CHANNEL = CHANNEL_TARGET;
+	static const unsigned TRIGGER_VOLUMES = TRIGGER_BODY;
+	void doSomething() { }
+	bool isInert() const { return true; }
+	void playerInside(PeachActor* peach, unsigned volumes);
 private:
 	virtual void doPlayerTargetAction(PlayerActor* player) = 0;
 };
@@ -180,6 +238,7 @@ private:
 //
 class FlagPlayerTargetActor : public PlayerTargetActor {
 public:
+	static const ActorKind KIND = KIND_FLAG;
 	FlagPlayerTargetActor(StudentWorld* world, int x, int y) 
 		: PlayerTargetActor(world, IID_FLAG, x, y, DIRECTION_RIGHT, DEPTH_BOTTOM + 1, DEFAULT_SIZE, !BLOCKING, !DAMAGABLE) { }
 private:
@@ -191,6 +250,7 @@ private:
 //
 class MarioPlayerTargetActor : public PlayerTargetActor {
 public:
+	static const ActorKind KIND = KIND_MARIO;
 	MarioPlayerTargetActor(StudentWorld* world, int x, int y) 
 		: PlayerTargetActor(world, IID_MARIO, x, y, DIRECTION_RIGHT, DEPTH_BOTTOM + 1, DEFAULT_SIZE, !BLOCKING, !DAMAGABLE) { }
 private:
@@ -204,14 +264,20 @@ class ObstacleActor : public Actor {
 public:
 	ObstacleActor(StudentWorld* world, int iid, int x, int y) 
 		: Actor(world, iid, x, y, DIRECTION_RIGHT, DEPTH_BOTTOM + 2, DEFAULT_SIZE, BLOCKING, !DAMAGABLE) { }
+	static const unsigned CATEGORY = CATEGORY_TERRAIN;
+	static const ObservationChannel OBSERVATION_CHANNEL = CHANNEL_TERRAIN;
+	static const bool STATELESS_TERRAIN = true;
 	void doSomething() { }
-	bool bonkedBy(Actor* actor);
+	bool isInert() const { return true; }
+	bool bonkedBy(Actor* actor) { return obstacleBonkedBy(getWorld(), actor); }
+	static bool obstacleBonkedBy(StudentWorld* world, Actor* actor);
 };
 
 // PIPE Actor
 //
 class PipeActor : public ObstacleActor {
 public:
+	static const ActorKind KIND = KIND_PIPE;
 	PipeActor(StudentWorld* world, int x, int y) : ObstacleActor(world, IID_PIPE, x, y) { }
 };
 
@@ -219,6 +285,7 @@ public:
 //
 class BlockActor : public ObstacleActor {
 public:
+	static const ActorKind KIND = KIND_BLOCK;
 	BlockActor(StudentWorld* world, int x, int y) : ObstacleActor(world, IID_BLOCK, x, y) { }
 };
 
@@ -228,7 +295,10 @@ class GoodieBlockActor : public BlockActor
 {
 public:
 	GoodieBlockActor(StudentWorld* world, int x, int y, int items = 1) : BlockActor(world, x, y), m_items(items) { }
+	static const bool STATELESS_TERRAIN = false;
 	bool bonkedBy(Actor* actor);
+	void saveState(SnapshotWriter& writer) const { writer.putU8(m_items); }
+	void loadState(SnapshotReader& reader) { m_items = reader.getU8(); }
 private:
 	virtual Actor* createGoodie(StudentWorld* world, int x, int y) = 0;
 	bool hasItem() const { return m_items > 0; }
@@ -241,6 +311,7 @@ private:
 class StarGoodieBlockActor : public GoodieBlockActor
 {
 public:
+	static const ActorKind KIND = KIND_STAR_BLOCK;
 	StarGoodieBlockActor(StudentWorld* world, int x, int y) : GoodieBlockActor(world, x, y) { }
 private:
 	Actor* createGoodie(StudentWorld* world, int x, int y);
@@ -251,6 +322,7 @@ private:
 class FlowerGoodieBlockActor : public GoodieBlockActor
 {
 public:
+	static const ActorKind KIND = KIND_FLOWER_BLOCK;
 	FlowerGoodieBlockActor(StudentWorld* world, int x, int y) : GoodieBlockActor(world, x, y) { }
 private:
 	Actor* createGoodie(StudentWorld* world, int x, int y);
@@ -261,6 +333,7 @@ private:
 class MushroomGoodieBlockActor : public GoodieBlockActor
 {
 public:
+	static const ActorKind KIND = KIND_MUSHROOM_BLOCK;
 	MushroomGoodieBlockActor(StudentWorld* world, int x, int y) : GoodieBlockActor(world, x, y) { }
 private:
 	Actor* createGoodie(StudentWorld* world, int x, int y);
@@ -273,7 +346,11 @@ class GoodieActor : public Actor
 public:
 	GoodieActor(StudentWorld* world, int iid, int x, int y) 
 		: Actor(world, iid, x, y, DIRECTION_RIGHT, DEPTH_BOTTOM + 1, DEFAULT_SIZE, !BLOCKING, !DAMAGABLE) { }
+	static const unsigned CATEGORY = CATEGORY_PICKUP;
+	static const ObservationChannel OBSERVATION_CHANNEL = CHANNEL_PICKUP;
+	static const unsigned TRIGGER_VOLUMES = TRIGGER_BODY;
 	void doSomething();
+	void playerInside(PeachActor* peach, unsigned volumes);
 private:
 	virtual void giveGoodiesTo(PeachActor* peach) = 0;
 	bool doMove();
@@ -286,6 +363,7 @@ private:
 //
 class FlowerGoodieActor : public GoodieActor {
 public:
+	static const ActorKind KIND = KIND_FLOWER;
 	FlowerGoodieActor(StudentWorld* world, int x, int y) : GoodieActor(world, IID_FLOWER, x, y) { }
 private:
 	void giveGoodiesTo(PeachActor* peach);
@@ -298,6 +376,7 @@ private:
 //
 class MushroomGoodieActor : public GoodieActor {
 public:
+	static const ActorKind KIND = KIND_MUSHROOM;
 	MushroomGoodieActor(StudentWorld* world, int x, int y) : GoodieActor(world, IID_MUSHROOM, x, y) { }
 private:
 	void giveGoodiesTo(PeachActor* peach);
@@ -310,6 +389,7 @@ private:
 //
 class StarGoodieActor : public GoodieActor {
 public:
+	static const ActorKind KIND = KIND_STAR;
 	StarGoodieActor(StudentWorld* world, int x, int y) : GoodieActor(world, IID_STAR, x, y) { }
 private:
 	void giveGoodiesTo(PeachActor* peach);
@@ -324,8 +404,10 @@ class EnemyActor : public Actor {
 public:
 	EnemyActor(StudentWorld* world, int iid, int x, int y) 
 		: Actor(world, iid, x, y, DIRECTION_RANDOM, DEPTH_BOTTOM, DEFAULT_SIZE, !BLOCKING, DAMAGABLE) { }
+	static const unsigned CATEGORY = CATEGORY_ENEMY;
+	static const unsigned BONK_MASK = CATEGORY_PLAYER;
 	virtual void doSomething() = 0;
-	bool bonk(Actor* actor);
+	bool canBonk(Actor* actor) { return actor->isAlive(); }
 	bool bonkedBy(Actor* actor);
 	bool damagedBy(Actor* actor);
 protected:
@@ -339,6 +421,8 @@ protected:
 //
 class GoombaEnemyActor : public EnemyActor {
 public:
+	static const ActorKind KIND = KIND_GOOMBA;
+	static const ObservationChannel OBSERVATION_CHANNEL = CHANNEL_GOOMBA;
 	GoombaEnemyActor(StudentWorld* world, int x, int y) : EnemyActor(world, IID_GOOMBA, x, y) { }
 	void doSomething();
 private:
@@ -348,6 +432,8 @@ private:
 //
 class KoopaEnemyActor : public EnemyActor {
 public:
+	static const ActorKind KIND = KIND_KOOPA;
+	static const ObservationChannel OBSERVATION_CHANNEL = CHANNEL_KOOPA;
 	KoopaEnemyActor(StudentWorld* world, int x, int y) : EnemyActor(world, IID_KOOPA, x, y) { }
 	void doSomething();
 	bool bonkedBy(Actor* actor);
@@ -360,15 +446,22 @@ private:
 //
 class PiranhaEnemyActor : public EnemyActor {
 public:
+	static const ActorKind KIND = KIND_PIRANHA;
+	static const ObservationChannel OBSERVATION_CHANNEL = CHANNEL_PIRANHA;
 	PiranhaEnemyActor(StudentWorld* world, int x, int y) : EnemyActor(world, IID_PIRANHA, x, y), m_firingDelay(0) { }
+	static const unsigned TRIGGER_VOLUMES = TRIGGER_SIGHT;
+	static constexpr double SIGHT_HEIGHT = 1.5 * SPRITE_HEIGHT;
 	void doSomething();
+	void playerInside(PeachActor* peach, unsigned volumes) { m_playerInSight = true; }
+	void saveState(SnapshotWriter& writer) const { writer.putU8(m_firingDelay); writer.putBool(m_playerInSight); }
+	void loadState(SnapshotReader& reader) { m_firingDelay = reader.getU8(); m_playerInSight = reader.getBool(); }
 private:
-	bool doTurnTowards(Actor* actor);
+	void doTurnTowards(Actor* actor);
 	bool doFireAt(Actor* actor);
-	const double DETECTION_HEIGHT = 1.5 * SPRITE_HEIGHT;
 	const int FIRING_RANGE = 8 * SPRITE_WIDTH;
 	const int FIRING_DELAY = 40;
 	int m_firingDelay;
+	bool m_playerInSight = false;
 };
 
 // TEMPORARY DAMAGING Actor abstract class
@@ -377,6 +470,8 @@ class TemporaryActor : public Actor {
 public:
 	TemporaryActor(StudentWorld* world, int iid, int x, int y, int direction)
 		: Actor(world, iid, x, y, direction, DEPTH_BOTTOM + 1, DEFAULT_SIZE, !BLOCKING, !DAMAGABLE) { }
+	static const unsigned CATEGORY = CATEGORY_PROJECTILE;
+	static const ObservationChannel OBSERVATION_CHANNEL = CHANNEL_PLAYER_PROJECTILE;
     virtual void doSomething() = 0;
 protected:
 	bool doMove();
@@ -390,8 +485,10 @@ class ShellActor : public TemporaryActor {
 public:
 	ShellActor(StudentWorld* world, int x, int y, int direction) 
 		: TemporaryActor(world, IID_SHELL, x, y, direction) { }
+	static const ActorKind KIND = KIND_SHELL;
+	static const unsigned DAMAGE_MASK = CATEGORY_ENEMY;
 	void doSomething();
-	bool damage(Actor* actor);
+	bool canDamage(Actor* actor);
 };
 
 // PEACH Fireball Actor
@@ -400,8 +497,10 @@ class PeachFireballActor : public TemporaryActor {
 public:
 	PeachFireballActor(StudentWorld* world, int x, int y, int direction) 
 		: TemporaryActor(world, IID_PEACH_FIRE, x, y, direction) { }
+	static const ActorKind KIND = KIND_PEACH_FIRE;
+	static const unsigned DAMAGE_MASK = CATEGORY_ENEMY;
 	void doSomething();
-	bool damage(Actor* actor);
+	bool canDamage(Actor* actor);
 };
 
 // PIRAHNA Fireball Actor
@@ -410,8 +509,13 @@ class PiranhaFireballActor : public TemporaryActor {
 public:
 	PiranhaFireballActor(StudentWorld* world, int x, int y, int direction) 
 		: TemporaryActor(world, IID_PIRANHA_FIRE, x, y, direction) { }
+	static const ActorKind KIND = KIND_PIRANHA_FIRE;
+	static const ObservationChannel OBSERVATION_CHANNEL = CHANNEL_ENEMY_PROJECTILE;
+	static const unsigned DAMAGE_MASK = CATEGORY_PLAYER;
+	static const unsigned TRIGGER_VOLUMES = TRIGGER_BODY;
 	void doSomething();
-	bool damage(Actor* actor);
+	void playerInside(PeachActor* peach, unsigned volumes);
+	bool canDamage(Actor* actor) { return actor->isAlive(); }
 };
 
 #endif // ACTOR_H_
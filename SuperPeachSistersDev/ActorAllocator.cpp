@@ -0,0 +1,107 @@
+#include "ActorAllocator.h"
+#include <algorithm>
+#include <cassert>
+using namespace std;
+
+// LEVEL ARENA
+//
+LevelArena::~LevelArena()
+{
+	for (char* chunk : m_chunks)
+	{
+		delete[] chunk;
+	}
+}
+
+size_t LevelArena::chunkSize(size_t chunk)
+{
+	size_t size = FIRST_CHUNK_SIZE << (chunk < 6 ? chunk : 6);
+	return size < CHUNK_SIZE ? size : CHUNK_SIZE;
+}
+
+void* LevelArena::allocate(size_t size)
+{
+	assert(size <= CHUNK_SIZE);
+	size = (size + ALIGNMENT - 1) & ~(ALIGNMENT - 1);
+	if (m_chunks.empty())
+	{
+		m_chunks.push_back(new char[chunkSize(0)]);
+	}
+	// chunks too small for the size are passed over; the last is always big enough
+	while (m_used + size > chunkSize(m_chunk))
+	{
+		m_chunk++;
+		if (m_chunk == m_chunks.size())
+		{
+			m_chunks.push_back(new char[chunkSize(m_chunk)]);
+		}
+		m_used = 0;
+	}
+	void* memory = m_chunks[m_chunk] + m_used;
+	m_used += size;
+	return memory;
+}
+
+void LevelArena::release()
+{
+	m_chunk = 0;
+	m_used = 0;
+}
+
+// ACTOR POOL
+//
+ActorPool::~ActorPool()
+{
+	for (char* chunk : m_chunks)
+	{
+		delete[] chunk;
+	}
+}
+
+size_t ActorPool::blocksIn(size_t chunk)
+{
+	size_t blocks = FIRST_CHUNK_BLOCKS << (chunk < 4 ? chunk : 4);
+	return blocks < BLOCKS_PER_CHUNK ? blocks : BLOCKS_PER_CHUNK;
+}
+
+void* ActorPool::allocate(size_t size)
+{
+	if (m_blockSize == 0)
+	{
+		m_blockSize = (max(size, sizeof(FreeBlock)) + ALIGNMENT - 1) & ~(ALIGNMENT - 1);
+	}
+	assert(size <= m_blockSize);
+	if (m_free != nullptr)
+	{
+		FreeBlock* block = m_free;
+		m_free = block->next;
+		return block;
+	}
+	if (m_chunks.empty() || m_used == blocksIn(m_chunk))
+	{
+		if (!m_chunks.empty())
+		{
+			m_chunk++;
+		}
+		if (m_chunk == m_chunks.size())
+		{
+			m_chunks.push_back(new char[m_blockSize * blocksIn(m_chunk)]);
+		}
+		m_used = 0;
+	}
+	return m_chunks[m_chunk] + m_blockSize * m_used++;
+}
+
+void ActorPool::deallocate(void* block)
+{
+	FreeBlock* freed = static_cast<FreeBlock*>(block);
+	freed->next = m_free;
+	m_free = freed;
+}
+
+void ActorPool::release()
+{
+	m_free = nullptr;
+	m_chunk = 0;
+	m_used = 0;
+}
@@ -0,0 +1,70 @@
+#ifndef ACTORALLOCATOR_H_
+#define ACTORALLOCATOR_H_
+
+#include <cstddef>
+#include <vector>
+
+// Bump allocator for the terrain, which lives as long as the level; nothing is freed individually, release()
+// rewinds to the start and keeps the chunks so the next level allocates without touching the heap. Chunks start
+// small and double, as a world sharing its terrain builds only the few terrain actors with state.
+//
+class LevelArena
+{
+public:
+	LevelArena() { }
+	~LevelArena();
+
+	void* allocate(std::size_t size);
+	void release();
+
+private:
+	static const std::size_t FIRST_CHUNK_SIZE = 1024;
+	static const std::size_t CHUNK_SIZE = 64 * 1024;
+	static const std::size_t ALIGNMENT = alignof(std::max_align_t);
+	static std::size_t chunkSize(std::size_t chunk);
+
+	std::vector<char*> m_chunks;
+	std::size_t m_chunk = 0;
+	std::size_t m_used = 0;
+
+	LevelArena(const LevelArena&);
+	LevelArena& operator=(const LevelArena&);
+};
+
+// Contiguous blocks for the actors of one kind; blocks are handed out in address order and recycled through a
+// free list when actors die, and release() takes every block back at once for the next level. Chunks start at a
+// few blocks and double, since most levels have only a handful of actors of any one kind.
+//
+class ActorPool
+{
+public:
+	ActorPool() { }
+	~ActorPool();
+
+	// the first allocation fixes the block size, every actor of a kind has the same size
+	void* allocate(std::size_t size);
+	void deallocate(void* block);
+	void release();
+
+private:
+	static const std::size_t FIRST_CHUNK_BLOCKS = 4;
+	static const std::size_t BLOCKS_PER_CHUNK = 64;
+	static const std::size_t ALIGNMENT = alignof(std::max_align_t);
+	static std::size_t blocksIn(std::size_t chunk);
+
+	struct FreeBlock
+	{
+		FreeBlock* next;
+	};
+
+	std::vector<char*> m_chunks;
+	std::size_t m_blockSize = 0;
+	std::size_t m_chunk = 0;
+	std::size_t m_used = 0;
+	FreeBlock* m_free = nullptr;
+
+	ActorPool(const ActorPool&);
+	ActorPool& operator=(const ActorPool&);
+};
+
+#endif // ACTORALLOCATOR_H_
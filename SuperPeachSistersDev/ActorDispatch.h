@@ -0,0 +1,168 @@
+#ifndef ACTORDISPATCH_H_
+#define ACTORDISPATCH_H_
+
+#include "Actor.h"
+#include <array>
+
+// Every concrete actor class, listed in ActorKind order so a class's position in the list is its kind
+//
+template <class... Types>
+struct ActorTypeList { };
+
+typedef ActorTypeList<
+	PeachActor, GoombaEnemyActor, KoopaEnemyActor, PiranhaEnemyActor,
+	PeachFireballActor, PiranhaFireballActor, ShellActor,
+	StarGoodieActor, FlowerGoodieActor, MushroomGoodieActor,
+	FlagPlayerTargetActor, MarioPlayerTargetActor,
+	BlockActor, PipeActor, StarGoodieBlockActor, FlowerGoodieBlockActor, MushroomGoodieBlockActor
+> AllActorTypes;
+
+template <class... Types>
+constexpr bool kindsMatchListOrder(ActorTypeList<Types...>)
+{
+	int kind = 0;
+	for (ActorKind listed : { Types::KIND... })
+	{
+		if (listed != kind++)
+		{
+			return false;
+		}
+	}
+	return kind == KIND_COUNT;
+}
+
+static_assert(kindsMatchListOrder(AllActorTypes()), "AllActorTypes must list one class per ActorKind, in ActorKind order");
+
+// Interaction tables: entry [a][b] handles an actor of kind a bonking or damaging an actor of kind b, with every call
+// resolved at compile time from the two concrete classes
+//
+typedef bool (*InteractionFunction)(Actor* actor, Actor* other);
+typedef std::array<InteractionFunction, KIND_COUNT> InteractionRow;
+typedef std::array<InteractionRow, KIND_COUNT> InteractionTable;
+
+template <class ActorType, class OtherType>
+struct BonkInteraction
+{
+	static bool apply(Actor* actor, Actor* other)
+	{
+		ActorType* bonker = static_cast<ActorType*>(actor);
+		OtherType* bonked = static_cast<OtherType*>(other);
+		return bonker->ActorType::canBonk(bonked) && bonked->OtherType::bonkedBy(bonker);
+	}
+};
+
+template <class ActorType, class OtherType>
+struct DamageInteraction
+{
+	static bool apply(Actor* actor, Actor* other)
+	{
+		ActorType* damager = static_cast<ActorType*>(actor);
+		OtherType* damaged = static_cast<OtherType*>(other);
+		return damager->ActorType::canDamage(damaged) && damaged->OtherType::damagedBy(damager);
+	}
+};
+
+template <template <class, class> class Interaction, class ActorType, class... OtherTypes>
+constexpr InteractionRow makeInteractionRow(ActorTypeList<OtherTypes...>)
+{
+	return InteractionRow{ { &Interaction<ActorType, OtherTypes>::apply... } };
+}
+
+template <template <class, class> class Interaction, class... Types>
+constexpr InteractionTable makeInteractionTable(ActorTypeList<Types...> types)
+{
+	return InteractionTable{ { makeInteractionRow<Interaction, Types>(types)... } };
+}
+
+// Interaction masks: entry [a] holds the categories an actor of kind a can bonk or damage with any effect, so
+// queries made on its behalf never gather the rest
+//
+typedef std::array<unsigned, KIND_COUNT> InteractionMasks;
+
+template <class... Types>
+constexpr InteractionMasks makeBonkMasks(ActorTypeList<Types...>)
+{
+	return InteractionMasks{ { Types::BONK_MASK... } };
+}
+
+template <class... Types>
+constexpr InteractionMasks makeDamageMasks(ActorTypeList<Types...>)
+{
+	return InteractionMasks{ { Types::DAMAGE_MASK... } };
+}
+
+// Trigger volumes registered by each kind, and the half height of the sight band for kinds that register one
+//
+typedef std::array<double, KIND_COUNT> SightHeights;
+
+template <class... Types>
+constexpr InteractionMasks makeTriggerVolumes(ActorTypeList<Types...>)
+{
+	return InteractionMasks{ { Types::TRIGGER_VOLUMES... } };
+}
+
+template <class... Types>
+constexpr SightHeights makeSightHeights(ActorTypeList<Types...>)
+{
+	return SightHeights{ { Types::SIGHT_HEIGHT... } };
+}
+
+// Collision category of each kind, and whether a kind is stateless terrain
+//
+typedef std::array<bool, KIND_COUNT> KindFlags;
+
+template <class... Types>
+constexpr InteractionMasks makeCategories(ActorTypeList<Types...>)
+{
+	return InteractionMasks{ { Types::CATEGORY... } };
+}
+
+template <class... Types>
+constexpr KindFlags makeStatelessTerrain(ActorTypeList<Types...>)
+{
+	return KindFlags{ { Types::STATELESS_TERRAIN... } };
+}
+
+// Observation channel of each kind
+//
+typedef std::array<ObservationChannel, KIND_COUNT> ObservationChannels;
+
+template <class... Types>
+constexpr ObservationChannels makeObservationChannels(ActorTypeList<Types...>)
+{
+	return ObservationChannels{ { Types::OBSERVATION_CHANNEL... } };
+}
+
+// Snapshot state functions of each kind, calling the class's own saveState and loadState
+//
+typedef void (*SaveStateFunction)(const Actor* actor, SnapshotWriter& writer);
+typedef void (*LoadStateFunction)(Actor* actor, SnapshotReader& reader);
+typedef std::array<SaveStateFunction, KIND_COUNT> SaveStateFunctions;
+typedef std::array<LoadStateFunction, KIND_COUNT> LoadStateFunctions;
+
+template <class ActorType>
+struct StateFunctions
+{
+	static void save(const Actor* actor, SnapshotWriter& writer)
+	{
+		static_cast<const ActorType*>(actor)->ActorType::saveState(writer);
+	}
+	static void load(Actor* actor, SnapshotReader& reader)
+	{
+		static_cast<ActorType*>(actor)->ActorType::loadState(reader);
+	}
+};
+
+template <class... Types>
+constexpr SaveStateFunctions makeSaveStateFunctions(ActorTypeList<Types...>)
+{
+	return SaveStateFunctions{ { &StateFunctions<Types>::save... } };
+}
+
+template <class... Types>
+constexpr LoadStateFunctions makeLoadStateFunctions(ActorTypeList<Types...>)
+{
+	return LoadStateFunctions{ { &StateFunctions<Types>::load... } };
+}
+
+#endif // ACTORDISPATCH_H_
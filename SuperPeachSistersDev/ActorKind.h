@@ -0,0 +1,62 @@
+#ifndef ACTORKIND_H_
+#define ACTORKIND_H_
+
+// Concrete actor kinds; the world keeps one pool and one active list per kind, and merges the lists into actor order
+// to tick them
+//
+enum ActorKind
+{
+	KIND_PEACH, KIND_GOOMBA, KIND_KOOPA, KIND_PIRANHA,
+	KIND_PEACH_FIRE, KIND_PIRANHA_FIRE, KIND_SHELL,
+	KIND_STAR, KIND_FLOWER, KIND_MUSHROOM,
+	KIND_FLAG, KIND_MARIO,
+	KIND_BLOCK, KIND_PIPE, KIND_STAR_BLOCK, KIND_FLOWER_BLOCK, KIND_MUSHROOM_BLOCK,
+	KIND_COUNT
+};
+
+// Collision categories; every actor is in exactly one, and world queries carry a mask of the categories they
+// can affect so everything else is passed over before any overlap test
+//
+enum ActorCategory
+{
+	CATEGORY_TERRAIN = 1 << 0,
+	CATEGORY_ENEMY = 1 << 1,
+	CATEGORY_PLAYER = 1 << 2,
+	CATEGORY_PICKUP = 1 << 3,
+	CATEGORY_PROJECTILE = 1 << 4,
+	CATEGORY_TRIGGER = 1 << 5,
+	CATEGORY_NONE = 0,
+	CATEGORY_ALL = (1 << 6) - 1
+};
+
+// Only terrain blocks movement; a blocking actor outside these categories would be missed by movement queries
+const unsigned BLOCKING_CATEGORIES = CATEGORY_TERRAIN;
+
+// Trigger volumes a sensor actor can register; the world tests the player against them once a tick and calls the
+// sensor back with the volumes the player is inside
+//
+enum TriggerVolume
+{
+	TRIGGER_NONE = 0,
+	TRIGGER_BODY = 1 << 0,		// the sensor's own sprite
+	TRIGGER_SIGHT = 1 << 1		// a band the width of the level centred on the sensor's height
+};
+
+// Channels of the world's observation grid; each kind counts towards one, so agents see enemies apart but
+// every kind of block as plain terrain
+//
+enum ObservationChannel
+{
+	CHANNEL_TERRAIN,
+	CHANNEL_PEACH,
+	CHANNEL_GOOMBA,
+	CHANNEL_KOOPA,
+	CHANNEL_PIRANHA,
+	CHANNEL_PICKUP,
+	CHANNEL_PLAYER_PROJECTILE,	// Peach's fireballs and kicked shells
+	CHANNEL_ENEMY_PROJECTILE,
+	CHANNEL_TARGET,				// the flag and Mario
+	CHANNEL_COUNT
+};
+
+#endif // ACTORKIND_H_
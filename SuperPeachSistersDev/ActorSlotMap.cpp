@@ -0,0 +1,96 @@
+#include "ActorSlotMap.h"
+using namespace std;
+
+ActorHandle ActorSlotMap::insert(Actor* actor)
+{
+	uint32_t index;
+	if (!m_freeSlots.empty())
+	{
+		index = m_freeSlots.back();
+		m_freeSlots.pop_back();
+	}
+	else
+	{
+		index = (uint32_t)m_slots.size();
+		m_slots.push_back(Slot{ 0, 0 });
+	}
+	m_slots[index].dense = (uint32_t)m_dense.size();
+	m_dense.push_back(actor);
+	m_denseSlots.push_back(index);
+
+	ActorHandle handle;
+	handle.index = index;
+	handle.generation = m_slots[index].generation;
+	return handle;
+}
+
+void ActorSlotMap::erase(ActorHandle handle)
+{
+	if (get(handle) == nullptr)
+	{
+		return;
+	}
+	Slot& slot = m_slots[handle.index];
+	m_dense[slot.dense] = nullptr;
+	slot.generation++;
+	m_freeSlots.push_back(handle.index);
+	m_hasErased = true;
+}
+
+void ActorSlotMap::compact()
+{
+	if (!m_hasErased)
+	{
+		return;
+	}
+	// stable, so iteration order stays the insertion order
+	size_t kept = 0;
+	for (size_t i = 0; i < m_dense.size(); i++)
+	{
+		if (m_dense[i] == nullptr)
+		{
+			continue;
+		}
+		m_dense[kept] = m_dense[i];
+		m_denseSlots[kept] = m_denseSlots[i];
+		m_slots[m_denseSlots[kept]].dense = (uint32_t)kept;
+		kept++;
+	}
+	m_dense.resize(kept);
+	m_denseSlots.resize(kept);
+	m_hasErased = false;
+}
+
+void ActorSlotMap::clear()
+{
+	// generations survive a clear so handles from the previous level never resolve
+	for (size_t i = 0; i < m_dense.size(); i++)
+	{
+		if (m_dense[i] != nullptr)
+		{
+			m_slots[m_denseSlots[i]].generation++;
+		}
+	}
+	m_freeSlots.clear();
+	for (uint32_t index = (uint32_t)m_slots.size(); index > 0; index--)
+	{
+		m_freeSlots.push_back(index - 1);
+	}
+	m_dense.clear();
+	m_denseSlots.clear();
+	m_hasErased = false;
+}
+
+Actor* ActorSlotMap::get(ActorHandle handle) const
+{
+	if (handle.index >= m_slots.size())
+	{
+		return nullptr;
+	}
+	const Slot& slot = m_slots[handle.index];
+	if (slot.generation != handle.generation)
+	{
+		return nullptr;
+	}
+	return m_dense[slot.dense];
+}
@@ -0,0 +1,57 @@
+#ifndef ACTORSLOTMAP_H_
+#define ACTORSLOTMAP_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+class Actor;
+
+// Handle to an actor in the world; the generation makes handles to removed actors resolve to nothing
+// instead of to whichever actor reused the slot
+//
+struct ActorHandle
+{
+	uint32_t index = INVALID_INDEX;
+	uint32_t generation = 0;
+
+	static const uint32_t INVALID_INDEX = 0xFFFFFFFF;
+	bool isValid() const { return index != INVALID_INDEX; }
+	bool operator==(const ActorHandle& other) const { return index == other.index && generation == other.generation; }
+	bool operator!=(const ActorHandle& other) const { return !(*this == other); }
+};
+
+// Contiguous actor storage with stable generational handles; actors are kept densely packed in the order they
+// were inserted, erase only clears the entry and compact() squeezes the cleared entries out in one pass
+//
+class ActorSlotMap
+{
+public:
+	ActorHandle insert(Actor* actor);
+	void erase(ActorHandle handle);
+	void compact();
+	void clear();
+
+	Actor* get(ActorHandle handle) const;
+
+	// dense iteration, entries erased since the last compact() are null
+	std::size_t size() const { return m_dense.size(); }
+	Actor* operator[](std::size_t i) const { return m_dense[i]; }
+	std::vector<Actor*>::const_iterator begin() const { return m_dense.begin(); }
+	std::vector<Actor*>::const_iterator end() const { return m_dense.end(); }
+
+private:
+	struct Slot
+	{
+		uint32_t generation;
+		uint32_t dense;
+	};
+
+	std::vector<Slot> m_slots;
+	std::vector<uint32_t> m_freeSlots;
+	std::vector<Actor*> m_dense;
+	std::vector<uint32_t> m_denseSlots;
+	bool m_hasErased = false;
+};
+
+#endif // ACTORSLOTMAP_H_
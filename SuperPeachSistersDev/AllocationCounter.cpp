@@ -0,0 +1,32 @@
+#include "AllocationCounter.h"
+#include <atomic>
+#include <cstdlib>
+#include <new>
+using namespace std;
+
+  // Replacements for the global operator new and delete, kept in their own file so no caller sees them inlined
+
+static atomic<long> s_allocations(0);
+
+long allocationCount()
+{
+	return s_allocations.load(memory_order_relaxed);
+}
+
+void* operator new(size_t size)
+{
+	s_allocations.fetch_add(1, memory_order_relaxed);
+	if (void* block = malloc(size == 0 ? 1 : size))
+		return block;
+	throw bad_alloc();
+}
+
+void operator delete(void* block) noexcept
+{
+	free(block);
+}
+
+void operator delete(void* block, size_t) noexcept
+{
+	free(block);
+}
@@ -0,0 +1,9 @@
+#ifndef ALLOCATIONCOUNTER_H_
+#define ALLOCATIONCOUNTER_H_
+
+// Every allocation through operator new in a program linking AllocationCounter.cpp is counted, so a benchmark can
+// check that the code it times allocates nothing. Only the headless program links it; the game and library do not.
+//
+long allocationCount();
+
+#endif // ALLOCATIONCOUNTER_H_
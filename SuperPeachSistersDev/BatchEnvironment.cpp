@@ -0,0 +1,145 @@
+#include "BatchEnvironment.h"
+#include "StudentWorld.h"
+#include "WorldRandom.h"
+#include "GameConstants.h"
+using namespace std;
+
+BatchEnvironment::BatchEnvironment(string assetPath, int worldCount, int startLevel, uint64_t seed,
+	unsigned int threadCount)
+ : m_pool(threadCount), m_startLevel(startLevel), m_seed(seed)
+{
+	if (!assetPath.empty() && assetPath.back() != '/')
+		assetPath += '/';
+	for (int i = 0; i < worldCount; i++)
+	{
+		Slot* slot = new Slot;
+		slot->world.reset(new StudentWorld(assetPath));
+		// worlds have no host: actions reach them through run(), and being silent as well, none builds the status
+		// text nobody would see
+		slot->world->setTerrainShared(true);
+		slot->world->setSilent(true);
+		m_slots.push_back(unique_ptr<Slot>(slot));
+	}
+}
+
+BatchEnvironment::~BatchEnvironment()
+{
+}
+
+bool BatchEnvironment::reset(const unsigned char* selected)
+{
+	m_pool.run(m_slots.size(), 1, [this, selected](size_t begin, size_t end) {
+		for (size_t i = begin; i < end; i++)
+		{
+			if (selected != nullptr && selected[i] == 0)
+				continue;
+			m_slots[i]->episodes = 0;
+			startEpisode((int)i);
+		}
+	});
+
+	for (size_t i = 0; i < m_slots.size(); i++)
+		if ((selected == nullptr || selected[i] != 0) && !m_slots[i]->loaded)
+			return false;
+	return true;
+}
+
+void BatchEnvironment::observe(unsigned char* observations)
+{
+	m_pool.run(m_slots.size(), chunkSize(), [this, observations](size_t begin, size_t end) {
+		for (size_t i = begin; i < end; i++)
+			m_slots[i]->world->writeObservation(observations + i * StudentWorld::OBSERVATION_SIZE);
+	});
+}
+
+void BatchEnvironment::observeEgocentric(unsigned char* observations)
+{
+	m_pool.run(m_slots.size(), chunkSize(), [this, observations](size_t begin, size_t end) {
+		for (size_t i = begin; i < end; i++)
+			m_slots[i]->world->writeEgocentricObservation(observations + i * StudentWorld::EGOCENTRIC_OBSERVATION_SIZE);
+	});
+}
+
+void BatchEnvironment::startEpisode(int index)
+{
+	Slot& slot = *m_slots[index];
+	StudentWorld& world = *slot.world;
+
+	  // each world's episodes get their own seeds, so no two episodes in a batch play out alike
+	world.cleanUp();
+	world.restartGame(m_startLevel);
+	world.setSeed(WorldRandom::mix(m_seed ^ ((uint64_t)index << 32) ^ slot.episodes));
+	slot.episodes++;
+	slot.loaded = world.init() == GWSTATUS_CONTINUE_GAME;
+}
+
+void BatchEnvironment::stepWorld(int index, int action, int repeat, unsigned int stopOn, int* status, int* reward,
+	unsigned char* done, int* ticks)
+{
+	Slot& slot = *m_slots[index];
+	StudentWorld& world = *slot.world;
+
+	if (!slot.loaded)
+	{
+		*status = GWSTATUS_LEVEL_ERROR;
+		*reward = 0;
+		*done = 1;
+		*ticks = 0;
+		return;
+	}
+
+	if (!m_actionKeys.empty())
+		action = (action >= 0 && action < (int)m_actionKeys.size()) ? m_actionKeys[action] : 0;
+
+	StudentWorld::RunResult result = world.run(&action, 1, repeat, stopOn);
+	*status = result.status;
+	*reward = result.reward;
+	*ticks = result.ticks;
+	*done = *status != GWSTATUS_CONTINUE_GAME;
+	if (*done)
+		startEpisode(index);
+}
+
+size_t BatchEnvironment::chunkSize() const
+{
+	  // a few chunks per thread, so there is something left to steal when some worlds run slow
+	return m_slots.size() / (m_pool.getThreadCount() * 4);
+}
+
+void BatchEnvironment::step(const int* actions, int* statuses, int* rewards, unsigned char* dones,
+	unsigned char* observations)
+{
+	stepRepeat(actions, 1, 0, statuses, rewards, dones, nullptr, observations);
+}
+
+void BatchEnvironment::stepRepeat(const int* actions, int repeat, unsigned int stopOn, int* statuses, int* rewards,
+	unsigned char* dones, int* ticks, unsigned char* observations)
+{
+	  // the arguments wait in a member, so the job handed to the pool is just this
+	m_request = StepRequest{ actions, repeat, stopOn, statuses, rewards, dones, ticks, observations };
+	m_pool.run(m_slots.size(), chunkSize(), [this](size_t begin, size_t end) { stepRange(begin, end); });
+}
+
+void BatchEnvironment::stepRange(size_t begin, size_t end)
+{
+	const StepRequest& request = m_request;
+	for (size_t i = begin; i < end; i++)
+	{
+		int status;
+		int reward;
+		unsigned char done;
+		int ran;
+		stepWorld((int)i, request.actions != nullptr ? request.actions[i] : 0, request.repeat, request.stopOn,
+			&status, &reward, &done, &ran);
+		if (request.statuses != nullptr)
+			request.statuses[i] = status;
+		if (request.rewards != nullptr)
+			request.rewards[i] = reward;
+		if (request.dones != nullptr)
+			request.dones[i] = done;
+		if (request.ticks != nullptr)
+			request.ticks[i] = ran;
+		if (request.observations != nullptr)
+			m_slots[i]->world->writeObservation(request.observations + i * StudentWorld::OBSERVATION_SIZE);
+	}
+}
@@ -0,0 +1,95 @@
+#ifndef BATCHENVIRONMENT_H_
+#define BATCHENVIRONMENT_H_
+
+#include "WorkStealingPool.h"
+#include <string>
+#include <vector>
+#include <memory>
+#include <cstdint>
+
+class StudentWorld;
+
+// Owns a batch of worlds and steps them all at once on a work stealing pool, for training and search code that
+// wants many independent games rather than one fast one. An episode is one life on the start level: it ends
+// when the player dies, finishes the level or wins, and the world is then reset on the spot, with a new seed,
+// so every call to step() advances every world by exactly one tick.
+//
+class BatchEnvironment
+{
+public:
+	// threadCount counts the calling thread; 0 means one per hardware thread
+	BatchEnvironment(std::string assetPath, int worldCount, int startLevel = 1, uint64_t seed = 0,
+		unsigned int threadCount = 0);
+	~BatchEnvironment();
+
+	BatchEnvironment(const BatchEnvironment&) = delete;
+	BatchEnvironment& operator=(const BatchEnvironment&) = delete;
+
+	// Starts a new episode in every world, or only in the worlds whose entry in selected is nonzero; false if
+	// the start level could not be loaded
+	bool reset(const unsigned char* selected = nullptr);
+
+	// Gives world i the key actions[i] (a KEY_PRESS_ value, or 0 for none) and moves every world one tick. For
+	// each world this writes the status move() returned, the score it gained this tick and whether its episode
+	// ended, in which case the world has already been reset for the next step, and then the world's observation
+	// at observations + i * StudentWorld::OBSERVATION_SIZE. Any output may be null.
+	void step(const int* actions, int* statuses, int* rewards, unsigned char* dones,
+		unsigned char* observations = nullptr);
+
+	// Like step(), but each world holds its action for up to repeat ticks inside one call, stopping early when
+	// its episode ends or when a StudentWorld::RunStop condition in stopOn is met. Rewards are summed over the
+	// ticks, and ticks[i] says how many world i ran.
+	void stepRepeat(const int* actions, int repeat, unsigned int stopOn, int* statuses, int* rewards,
+		unsigned char* dones, int* ticks, unsigned char* observations = nullptr);
+
+	// Makes step() read actions as indexes into keys, so callers can use small action numbers; out of range
+	// actions press nothing
+	void setActionKeys(const int* keys, int count) { m_actionKeys.assign(keys, keys + count); }
+
+	// Writes every world's observation, laid out as in step(), or its egocentric window at
+	// observations + i * StudentWorld::EGOCENTRIC_OBSERVATION_SIZE
+	void observe(unsigned char* observations);
+	void observeEgocentric(unsigned char* observations);
+
+	int getWorldCount() const { return (int)m_slots.size(); }
+	unsigned int getThreadCount() const { return m_pool.getThreadCount(); }
+
+	StudentWorld& getWorld(int index) { return *m_slots[index]->world; }
+	unsigned long getEpisodes(int index) const { return m_slots[index]->episodes; }
+
+private:
+	struct Slot
+	{
+		std::unique_ptr<StudentWorld> world;
+		unsigned long episodes = 0;
+		bool loaded = false;
+	};
+
+	// the arguments of the step in progress
+	struct StepRequest
+	{
+		const int* actions;
+		int repeat;
+		unsigned int stopOn;
+		int* statuses;
+		int* rewards;
+		unsigned char* dones;
+		int* ticks;
+		unsigned char* observations;
+	};
+
+	size_t chunkSize() const;
+	void stepRange(size_t begin, size_t end);
+	void startEpisode(int index);
+	void stepWorld(int index, int action, int repeat, unsigned int stopOn, int* status, int* reward,
+		unsigned char* done, int* ticks);
+
+	std::vector<std::unique_ptr<Slot>> m_slots;
+	WorkStealingPool m_pool;
+	StepRequest m_request = {};
+	std::vector<int> m_actionKeys;
+	int m_startLevel;
+	uint64_t m_seed;
+};
+
+#endif // BATCHENVIRONMENT_H_
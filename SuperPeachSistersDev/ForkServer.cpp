@@ -0,0 +1,211 @@
+#include "ForkServer.h"
+#include "StudentWorld.h"
+#include "GameConstants.h"
+#include <iostream>
+#include <sstream>
+#include <vector>
+#include <cerrno>
+#include <cstring>
+#include <csignal>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <sys/un.h>
+using namespace std;
+
+static bool readAll(int fd, void* buffer, size_t size)
+{
+	char* bytes = static_cast<char*>(buffer);
+	while (size > 0)
+	{
+		ssize_t got = read(fd, bytes, size);
+		if (got < 0 && errno == EINTR)
+			continue;
+		if (got <= 0)
+			return false;
+		bytes += got;
+		size -= got;
+	}
+	return true;
+}
+
+static bool writeAll(int fd, const void* buffer, size_t size)
+{
+	const char* bytes = static_cast<const char*>(buffer);
+	while (size > 0)
+	{
+		ssize_t put = write(fd, bytes, size);
+		if (put < 0 && errno == EINTR)
+			continue;
+		if (put <= 0)
+			return false;
+		bytes += put;
+		size -= put;
+	}
+	return true;
+}
+
+static bool writeLine(int fd, const string& line)
+{
+	return writeAll(fd, line.data(), line.size());
+}
+
+static bool readLine(int fd, string& line)
+{
+	  // requests are short, so reading a byte at a time never reads past the line into a worker's steps
+	line.clear();
+	char c;
+	while (line.size() < 256)
+	{
+		if (!readAll(fd, &c, 1))
+			return false;
+		if (c == '\n')
+			return true;
+		line += c;
+	}
+	return false;
+}
+
+  // Reads on the socket give up after ms milliseconds, or never with 0
+static void setReadTimeout(int fd, int ms)
+{
+	timeval timeout;
+	timeout.tv_sec = ms / 1000;
+	timeout.tv_usec = (ms % 1000) * 1000;
+	setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+}
+
+ForkServer::ForkServer(string assetPath, int startLevel, uint64_t seed)
+ : m_assetPath(assetPath), m_startLevel(startLevel), m_seed(seed)
+{
+}
+
+ForkServer::~ForkServer()
+{
+	if (m_listener >= 0)
+		close(m_listener);
+}
+
+bool ForkServer::serve(const string& socketPath)
+{
+	  // the warm state every worker starts from
+	m_world.reset(new StudentWorld(m_assetPath));
+	m_world->setController(&m_host);
+	m_world->setTerrainShared(true);
+	m_world->setSeed(m_seed);
+	for (int level = 1; level < m_startLevel; level++)
+		m_world->advanceToNextLevel();
+	if (m_world->init() != GWSTATUS_CONTINUE_GAME)
+		return false;
+
+	sockaddr_un address;
+	memset(&address, 0, sizeof(address));
+	address.sun_family = AF_UNIX;
+	if (socketPath.size() >= sizeof(address.sun_path))
+	{
+		cerr << "Socket path too long: " << socketPath << endl;
+		return false;
+	}
+	strcpy(address.sun_path, socketPath.c_str());
+
+	m_listener = socket(AF_UNIX, SOCK_STREAM, 0);
+	unlink(socketPath.c_str());
+	if (m_listener < 0 || ::bind(m_listener, (sockaddr*)&address, sizeof(address)) != 0 || listen(m_listener, 64) != 0)
+	{
+		cerr << "Cannot listen on " << socketPath << ": " << strerror(errno) << endl;
+		return false;
+	}
+
+	  // workers are never waited for; ignoring SIGCHLD lets the system reap them. A client that hangs up shows
+	  // as a failed write rather than a signal, here and in the workers, which inherit this.
+	signal(SIGCHLD, SIG_IGN);
+	signal(SIGPIPE, SIG_IGN);
+
+	while (!m_quit)
+	{
+		int connection = accept(m_listener, nullptr, nullptr);
+		if (connection < 0)
+		{
+			if (errno == EINTR)
+				continue;
+			cerr << "accept failed: " << strerror(errno) << endl;
+			break;
+		}
+		handleConnection(connection);
+	}
+
+	close(m_listener);
+	m_listener = -1;
+	unlink(socketPath.c_str());
+	return true;
+}
+
+void ForkServer::handleConnection(int connection)
+{
+	string line;
+	setReadTimeout(connection, REQUEST_TIMEOUT_MS);
+	if (!readLine(connection, line))
+	{
+		close(connection);
+		return;
+	}
+
+	istringstream request(line);
+	string command;
+	request >> command;
+	if (command == "spawn")
+	{
+		uint64_t seed;
+		bool reseed = static_cast<bool>(request >> seed);
+		pid_t pid = fork();
+		if (pid == 0)
+		{
+			close(m_listener);
+			if (reseed)
+				m_world->reseed(seed);
+			runWorker(connection);
+			_exit(0);
+		}
+		if (pid < 0)
+			writeLine(connection, string("error ") + strerror(errno) + "\n");
+	}
+	else if (command == "quit")
+	{
+		writeLine(connection, "ok\n");
+		m_quit = true;
+	}
+	else
+	{
+		writeLine(connection, "error unknown request\n");
+	}
+	close(connection);
+}
+
+void ForkServer::runWorker(int connection)
+{
+	  // a client may take as long as it likes between steps
+	setReadTimeout(connection, 0);
+	if (!writeLine(connection, "ok " + to_string(getpid()) + "\n"))
+		return;
+
+	StudentWorld& world = *m_world;
+	vector<unsigned char> reply(sizeof(StepReply) + StudentWorld::OBSERVATION_SIZE);
+	for (;;)
+	{
+		int32_t key;
+		if (!readAll(connection, &key, sizeof(key)))
+			return;
+
+		int scoreBefore = world.getScore();
+		m_host.setKey(key);
+		StepReply step;
+		step.status = world.move();
+		step.reward = world.getScore() - scoreBefore;
+		step.done = step.status != GWSTATUS_CONTINUE_GAME;
+
+		memcpy(reply.data(), &step, sizeof(step));
+		world.writeObservation(reply.data() + sizeof(step));
+		if (!writeAll(connection, reply.data(), reply.size()) || step.done)
+			return;
+	}
+}
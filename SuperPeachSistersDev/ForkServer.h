@@ -0,0 +1,61 @@
+#ifndef FORKSERVER_H_
+#define FORKSERVER_H_
+
+#include "HeadlessHost.h"
+#include <string>
+#include <memory>
+#include <cstdint>
+
+class StudentWorld;
+
+// Serves ready-to-play worlds from one warm process (POSIX only). The server loads the level template and
+// builds and initialises a world once, then listens on a unix socket; each client that connects and asks for
+// a worker gets a fork()ed child holding its own copy-on-write copy of that world, so an episode starts with no
+// process start up, asset checks, parsing or actor construction. Worlds never touched by a child stay shared.
+//
+// Requests are one text line each:
+//
+//   spawn [seed]     fork a worker for this connection; the reply is "ok <pid>\n" and the connection then
+//                    belongs to the worker, which reseeds its world from the given seed if there is one
+//   quit             stop the server
+//
+// A client that has not sent its whole request line within REQUEST_TIMEOUT_MS of connecting is dropped, so one
+// that connects and goes quiet cannot hold up everyone after it.
+//
+// A worker plays one episode. Each step the client writes a 4 byte key (a KEY_PRESS_ value, or 0) and the worker
+// moves the world one tick and writes a StepReply followed by StudentWorld::OBSERVATION_SIZE bytes of
+// observation. The worker exits once the episode is over or the client hangs up. All integers are native endian.
+//
+class ForkServer
+{
+public:
+	static const int REQUEST_TIMEOUT_MS = 1000;
+
+	struct StepReply
+	{
+		int32_t status;
+		int32_t reward;
+		int32_t done;
+	};
+
+	ForkServer(std::string assetPath, int startLevel, uint64_t seed);
+	~ForkServer();
+
+	// Builds the warm world and serves requests until told to quit; false if the level cannot be loaded or the
+	// socket cannot be set up
+	bool serve(const std::string& socketPath);
+
+private:
+	void handleConnection(int connection);
+	void runWorker(int connection);
+
+	std::string m_assetPath;
+	int m_startLevel;
+	uint64_t m_seed;
+	ActionHost m_host;
+	std::unique_ptr<StudentWorld> m_world;
+	int m_listener = -1;
+	bool m_quit = false;
+};
+
+#endif // FORKSERVER_H_
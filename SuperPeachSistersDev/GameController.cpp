@@ -11,6 +11,7 @@
 #include <utility>
 #include <cstdlib>
 #include <algorithm>
+#include <random>
 using namespace std;
 
 /*
@@ -358,9 +359,9 @@ void GameController::displayGamePlay()
 #pragma GCC diagnostic pop
 #endif
 
-	for (int i = 4 /* NUM_DEPTHS */ - 1; i >= 0; --i)
+	for (int i = RenderRegistry::NUM_DEPTHS - 1; i >= 0; --i)
 	{
-		std::set<GraphObject*> &graphObjects = GraphObject::getGraphObjects(i);
+		const std::vector<GraphObject*> &graphObjects = m_gw->getRenderRegistry().getLayer(i);
 
 		for (auto it = graphObjects.begin(); it != graphObjects.end(); it++)
 		{
@@ -450,6 +451,19 @@ static void drawPrompt(string mainMessage, string secondMessage)
 	glutSwapBuffers();
 }
 
+  // Return a uniformly distributed random int from min to max, inclusive; only the display uses this generator,
+  // game play draws from its world's own
+
+static int randInt(int min, int max)
+{
+    if (max < min)
+        std::swap(max, min);
+    static std::random_device rd;
+    static std::default_random_engine generator(rd());
+    std::uniform_int_distribution<> distro(min, max);
+    return distro(generator);
+}
+
 static void drawScoreAndLives(string gameStatText)
 {
 	static int RATE = 1;
@@ -1,6 +1,7 @@
 #ifndef GAMECONTROLLER_H_
 #define GAMECONTROLLER_H_
 
+#include "GameHost.h"
 #include "SpriteManager.h"
 #include <string>
 #include <map>
@@ -11,12 +12,12 @@ const int INVALID_KEY = 0;
 class GraphObject;
 class GameWorld;
 
-class GameController
+class GameController : public GameHost
 {
   public:
 	void run(int argc, char* argv[], GameWorld* gw, std::string windowTitle);
 
-	bool getLastKey(int& value)
+	bool getLastKey(int& value) override
 	{
 		if (m_lastKeyHit != INVALID_KEY)
 		{
@@ -27,9 +28,9 @@ class GameController
 		return false;
 	}
 
-	void playSound(int soundID);
+	void playSound(int soundID) override;
 
-	void setGameStatText(std::string text)
+	void setGameStatText(std::string text) override
 	{
 		m_gameStatText = text;
 	}
@@ -40,7 +41,7 @@ class GameController
 	void keyboardEvent(unsigned char key, int x, int y);
 	void specialKeyboardEvent(int key, int x, int y);
 
-    void quitGame();
+    void quitGame() override;
 
 	  // Meyers singleton pattern
 	static GameController& getInstance()
@@ -50,7 +51,7 @@ class GameController
 	}
 
 	static void timerFuncCallback(int nothing);
-	void setMsPerTick(int ms_per_tick) { m_ms_per_tick = ms_per_tick;  }
+	void setMsPerTick(int ms_per_tick) override { m_ms_per_tick = ms_per_tick;  }
 
 private:
     enum GameControllerState : int;
@@ -0,0 +1,21 @@
+#ifndef GAMEHOST_H_
+#define GAMEHOST_H_
+
+#include <string>
+
+// What a GameWorld needs from whatever is running it: keys, sounds, the status line and the tick rate.
+// GameController is the GLUT host; a world with no host reads no keys and makes no sound.
+//
+class GameHost
+{
+public:
+	virtual ~GameHost() { }
+
+	virtual bool getLastKey(int& value) = 0;
+	virtual void playSound(int soundID) = 0;
+	virtual void setGameStatText(std::string text) = 0;
+	virtual void setMsPerTick(int ms_per_tick) = 0;
+	virtual void quitGame() = 0;
+};
+
+#endif // GAMEHOST_H_
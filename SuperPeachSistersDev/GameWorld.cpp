@@ -1,11 +1,14 @@
 #include "GameWorld.h"
-#include "GameController.h"
 #include <string>
 #include <cstdlib>
 using namespace std;
 
+  // Without a host (a headless world) there are no keys to read and nothing to show or play
+
 bool GameWorld::getKey(int& value)
 {
+	if (m_controller == nullptr)
+		return false;
 	bool gotKey = m_controller->getLastKey(value);
 
 	if (gotKey)
@@ -18,15 +21,18 @@ bool GameWorld::getKey(int& value)
 
 void GameWorld::playSound(int soundID)
 {
-	m_controller->playSound(soundID);
+	if (m_controller != nullptr && !m_silent)
+		m_controller->playSound(soundID);
 }
 
 void GameWorld::setGameStatText(string text)
 {
-	m_controller->setGameStatText(text);
+	if (m_controller != nullptr && !m_silent)
+		m_controller->setGameStatText(text);
 }
 
 void GameWorld::setMsPerTick(int ms_per_tick)
 {
-	m_controller->setMsPerTick(ms_per_tick);
+	if (m_controller != nullptr)
+		m_controller->setMsPerTick(ms_per_tick);
 }
@@ -2,12 +2,12 @@
 #define GAMEWORLD_H_
 
 #include "GameConstants.h"
+#include "GameHost.h"
+#include "RenderRegistry.h"
 #include <string>
 
 const int START_PLAYER_LIVES = 3;
 
-class GameController;
-
 class GameWorld
 {
 public:
@@ -72,24 +72,65 @@ public:
 	{
 		++m_level;
 	}
+
+	  // Back to a new game's lives and score, starting at the given level
+	void restartGame(int level)
+	{
+		m_lives = START_PLAYER_LIVES;
+		m_score = 0;
+		m_level = level;
+	}
+
+	  // Back to lives, score and level saved from another point in a game
+	void restoreProgress(int level, int lives, int score)
+	{
+		m_lives = lives;
+		m_score = score;
+		m_level = level;
+	}
  
-	void setController(GameController* controller)
+	void setController(GameHost* controller)
 	{
 		m_controller = controller;
 	}
 
+	GameHost* getController() const
+	{
+		return m_controller;
+	}
+
+	  // A silent world plays no sounds and shows no status text, for ticks replayed behind the player's back
+	void setSilent(bool silent)
+	{
+		m_silent = silent;
+	}
+
+	bool isSilent() const
+	{
+		return m_silent;
+	}
+
 	std::string assetPath() const
 	{
 		return m_assetPath;
 	}
 
 	void setMsPerTick(int ms_per_tick);
+
+	  // The graph objects of this world, for the host to draw
+	RenderRegistry& getRenderRegistry()
+	{
+		return m_renderRegistry;
+	}
+
 private:
 	int				m_lives;
 	int				m_score;
 	int				m_level;
-	GameController* m_controller;
+	GameHost*		m_controller;
+	bool			m_silent = false;
 	std::string		m_assetPath;
+	RenderRegistry	m_renderRegistry;
 };
 
 #endif // GAMEWORLD_H_
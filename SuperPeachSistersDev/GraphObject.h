@@ -1,10 +1,9 @@
 #ifndef GRAPHOBJ_H_
 #define GRAPHOBJ_H_
 
-#include "SpriteManager.h"
 #include "GameConstants.h"
+#include "RenderRegistry.h"
 
-#include <set>
 #include <cmath>
 
 const int ANIMATION_POSITIONS_PER_TICK = 1;
@@ -18,7 +17,9 @@ class GraphObject
 	static const int up = 90;
 	static const int down = 270;
 
-	GraphObject(int imageID, int startX, int startY, int dir = 0, int depth = 0, double size = 1.0)
+	  // Objects given a registry are shown by whatever draws that registry, until they are destroyed
+	GraphObject(int imageID, int startX, int startY, int dir = 0, int depth = 0, double size = 1.0,
+				RenderRegistry* registry = nullptr)
 	 : m_imageID(imageID), m_visible(true), m_x(startX), m_y(startY),
 	   m_destX(startX), m_destY(startY), m_brightness(1.0),
 	   m_animationNumber(0), m_direction(dir), m_depth(depth), m_size(size)
@@ -26,13 +27,15 @@ class GraphObject
 		if (m_size <= 0)
 			m_size = 1;
 
-		getGraphObjects(m_depth).insert(this);
+		if (registry != nullptr)
+			registry->add(this, m_depth);
 		setVisible(true);
 	}
 
 	virtual ~GraphObject()
 	{
-		getGraphObjects(m_depth).erase(this);
+		if (m_registry != nullptr)
+			m_registry->remove(this);
 	}
 
 	void setVisible(bool shouldIDisplay)
@@ -145,15 +148,6 @@ class GraphObject
 	//	moveALittle(m_y, m_destY);
 	}
 
-	static std::set<GraphObject*>& getGraphObjects(int layer)
-	{
-		static std::set<GraphObject*> graphObjects[NUM_DEPTHS];
-		if (layer < NUM_DEPTHS)
-			return graphObjects[layer];
-		else
-			return graphObjects[0];		// empty;
-	}
-
 	void increaseAnimationNumber()
 	{
 		m_animationNumber++;
@@ -162,6 +156,7 @@ class GraphObject
 
   private:
 	friend class GameController;
+	friend class RenderRegistry;
 	int getID() const
 	{
 		return m_imageID;
@@ -172,7 +167,6 @@ class GraphObject
 	GraphObject(const GraphObject&);
 	GraphObject& operator=(const GraphObject&);
 
-	static const int NUM_DEPTHS = 4;
 	int		m_imageID;
 	bool	m_visible;
 	double	m_x;
@@ -184,6 +178,8 @@ class GraphObject
 	int     m_direction;
 	int		m_depth;
 	double	m_size;
+	RenderRegistry* m_registry = nullptr;
+	size_t	m_renderIndex = 0;
 
 	void moveALittle(double& from, double& to)
 	{
@@ -0,0 +1,50 @@
+#include "HeadlessHost.h"
+#include "GameConstants.h"
+using namespace std;
+
+int HeadlessHost::keyFor(char c)
+{
+	switch (c)
+	{
+	case 'a': return KEY_PRESS_LEFT;
+	case 'd': return KEY_PRESS_RIGHT;
+	case 'w': return KEY_PRESS_UP;
+	case 's': return KEY_PRESS_DOWN;
+	case ' ': return KEY_PRESS_SPACE;
+	case 'q': return 'q';
+	default:  return 0;
+	}
+}
+
+int HeadlessHost::nextRandomKey()
+{
+	// mostly running right, with some backing off, jumping and firing
+	m_randomState = m_randomState * 1103515245 + 12345;
+	int roll = (m_randomState >> 16) % 20;
+	if (roll < 8) return KEY_PRESS_RIGHT;
+	if (roll < 11) return KEY_PRESS_LEFT;
+	if (roll < 14) return KEY_PRESS_UP;
+	if (roll < 16) return KEY_PRESS_SPACE;
+	return 0;
+}
+
+bool HeadlessHost::getLastKey(int& value)
+{
+	int key;
+	if (m_script.empty())
+	{
+		key = nextRandomKey();
+	}
+	else
+	{
+		// the script loops for as long as the run lasts
+		key = keyFor(m_script[m_position]);
+		m_position = (m_position + 1) % m_script.size();
+	}
+	if (key == 0)
+	{
+		return false;
+	}
+	value = key;
+	return true;
+}
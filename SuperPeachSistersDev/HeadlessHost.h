@@ -0,0 +1,60 @@
+#ifndef HEADLESSHOST_H_
+#define HEADLESSHOST_H_
+
+#include "GameHost.h"
+#include <string>
+
+// Host for running a world with no window: sounds and the status line go nowhere, and keys come from a script
+// played back one key per tick, or from a seeded random player when there is no script
+//
+class HeadlessHost : public GameHost
+{
+public:
+	// Script characters use the GLUT keyboard bindings: a, d, w, s to move, space to fire, and '.' for no key
+	HeadlessHost(std::string script = "", unsigned int seed = 1)
+		: m_script(script), m_randomState(seed) { }
+
+	bool getLastKey(int& value) override;
+	void playSound(int soundID) override { }
+	void setGameStatText(std::string text) override { }
+	void setMsPerTick(int ms_per_tick) override { }
+	void quitGame() override { m_quit = true; }
+
+	bool hasQuit() const { return m_quit; }
+
+private:
+	static int keyFor(char c);
+	int nextRandomKey();
+
+	std::string m_script;
+	size_t m_position = 0;
+	unsigned int m_randomState;
+	bool m_quit = false;
+};
+
+// Host for a world driven by other code: it is handed the key for each tick, which is read once like a real key
+// press, and everything else goes nowhere
+//
+class ActionHost : public GameHost
+{
+public:
+	void setKey(int key) { m_key = key; }
+
+	bool getLastKey(int& value) override
+	{
+		if (m_key == 0)
+			return false;
+		value = m_key;
+		m_key = 0;
+		return true;
+	}
+	void playSound(int soundID) override { }
+	void setGameStatText(std::string text) override { }
+	void setMsPerTick(int ms_per_tick) override { }
+	void quitGame() override { }
+
+private:
+	int m_key = 0;
+};
+
+#endif // HEADLESSHOST_H_
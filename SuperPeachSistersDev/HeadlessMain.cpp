@@ -0,0 +1,342 @@
+#include "StudentWorld.h"
+#include "GameConstants.h"
+#include "HeadlessHost.h"
+#include "BatchEnvironment.h"
+#include "ForkServer.h"
+#include "SharedMemoryServer.h"
+#include "RollbackSession.h"
+#include "Replay.h"
+#include "AllocationCounter.h"
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <cstdlib>
+#include <chrono>
+#include <vector>
+#include <algorithm>
+using namespace std;
+
+  // Runs the game with no window, sound or OpenGL, stepping the world as fast as the CPU allows:
+  //
+  //   SuperPeachSistersHeadless assetDirectory [-l level] [-t maxTicks] [-k keys] [-s seed] [-a] [-w replayFile]
+  //   SuperPeachSistersHeadless assetDirectory -p replayFile [-g tick] [-t maxTicks]
+  //   SuperPeachSistersHeadless assetDirectory -b worlds [-j threads] [-l level] [-t steps] [-s seed]
+  //   SuperPeachSistersHeadless assetDirectory -f socketPath [-l level] [-s seed]
+  //   SuperPeachSistersHeadless assetDirectory -m sharedMemoryName [-b worlds] [-j threads] [-l level] [-s seed]
+  //   SuperPeachSistersHeadless assetDirectory -r delay [-l level] [-t maxTicks] [-s seed]
+  //
+  // The run starts at the given level and ends when that level is finished, the player runs out of lives or
+  // maxTicks have been simulated; with -a it carries on through the following levels until the game is over.
+  // Keys are a script in the GLUT bindings (see HeadlessHost.h), played on a loop; without one a random player
+  // is used. The seed drives both the world's generator and the random player, so a run can be repeated exactly.
+  // With -b a BatchEnvironment of that many worlds is stepped instead, each by its own random player, and the
+  // run reports world ticks per second across the batch. With -f it becomes a fork server on that socket (see
+  // ForkServer.h), handing out workers that start from a world already built for the level. With -m it publishes
+  // a batch (one world unless -b says otherwise) through that shared memory segment (see SharedMemoryServer.h),
+  // stepping it with the actions a trainer in another process writes back. With -r it plays the rival's side of a
+  // race under rollback (see RollbackSession.h): a random rival's keys come over a loopback link that many ticks
+  // late, and the run checks the rolled back world ends up exactly where the world given every key on time is.
+  // With -w the run is recorded to a replay file (see Replay.h); -p plays one back through every level it covers,
+  // starting at tick -g, and reports whether the world matched each keyframe it passed.
+
+static const char* statusName(int status)
+{
+	switch (status)
+	{
+	case GWSTATUS_PLAYER_DIED:    return "player died";
+	case GWSTATUS_CONTINUE_GAME:  return "still playing";
+	case GWSTATUS_PLAYER_WON:     return "player won";
+	case GWSTATUS_FINISHED_LEVEL: return "finished level";
+	case GWSTATUS_LEVEL_ERROR:    return "level error";
+	}
+	return "unknown";
+}
+
+static int usage()
+{
+	cerr << "usage: SuperPeachSistersHeadless assetDirectory [-l level] [-t maxTicks] [-k keys] [-s seed] [-a] [-w replayFile]" << endl;
+	cerr << "       SuperPeachSistersHeadless assetDirectory -p replayFile [-g tick] [-t maxTicks]" << endl;
+	cerr << "       SuperPeachSistersHeadless assetDirectory -b worlds [-j threads] [-l level] [-t steps] [-s seed]" << endl;
+	cerr << "       SuperPeachSistersHeadless assetDirectory -f socketPath [-l level] [-s seed]" << endl;
+	cerr << "       SuperPeachSistersHeadless assetDirectory -m sharedMemoryName [-b worlds] [-j threads] [-l level] [-s seed]" << endl;
+	cerr << "       SuperPeachSistersHeadless assetDirectory -r delay [-l level] [-t maxTicks] [-s seed]" << endl;
+	return 1;
+}
+
+static int runBatch(string assetPath, int worldCount, unsigned int threadCount, int startLevel, long steps,
+	unsigned int seed)
+{
+	BatchEnvironment env(assetPath, worldCount, startLevel, seed, threadCount);
+	if (!env.reset())
+	{
+		cerr << "Cannot load level " << startLevel << endl;
+		return 1;
+	}
+
+	vector<HeadlessHost> players;
+	for (int i = 0; i < worldCount; i++)
+		players.push_back(HeadlessHost("", seed + i));
+	vector<int> actions(worldCount);
+	vector<int> statuses(worldCount);
+	vector<int> rewards(worldCount);
+	vector<unsigned char> dones(worldCount);
+
+	long episodes = 0;
+	long long totalReward = 0;
+	// worlds grow their buffers while they first meet each level and spawn; the second half shows the steady state
+	long allocations = allocationCount();
+	long halfAllocations = allocations;
+	auto start = chrono::steady_clock::now();
+	for (long step = 0; step < steps; step++)
+	{
+		if (step == steps / 2)
+			halfAllocations = allocationCount();
+		for (int i = 0; i < worldCount; i++)
+		{
+			int key = 0;
+			players[i].getLastKey(key);
+			actions[i] = key;
+		}
+		env.step(actions.data(), statuses.data(), rewards.data(), dones.data());
+		for (int i = 0; i < worldCount; i++)
+		{
+			totalReward += rewards[i];
+			episodes += dones[i];
+		}
+	}
+	double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+	halfAllocations = allocationCount() - halfAllocations;
+	allocations = allocationCount() - allocations;
+
+	long long ticks = (long long)steps * worldCount;
+	cout << worldCount << " worlds on " << env.getThreadCount() << " threads: " << episodes << " episodes, "
+		<< totalReward << " points" << endl;
+	cout << ticks << " ticks in " << seconds << " s";
+	if (seconds > 0)
+		cout << " (" << (long long)(ticks / seconds) << " ticks/sec)";
+	cout << endl;
+	cout << allocations << " allocations while stepping, " << halfAllocations << " in the second half";
+	if (steps > 1)
+		cout << " (" << (double)halfAllocations / (steps - steps / 2) << " per step)";
+	cout << endl;
+	return 0;
+}
+
+static int runRollback(string assetPath, int startLevel, long maxTicks, unsigned int seed, int delay)
+{
+	StudentWorld rival(assetPath);
+	StudentWorld reference(assetPath);
+	for (StudentWorld* world : { &rival, &reference })
+	{
+		world->setTerrainShared(true);
+		world->setSeed(seed);
+		for (int level = 1; level < startLevel; level++)
+			world->advanceToNextLevel();
+		if (world->init() != GWSTATUS_CONTINUE_GAME)
+		{
+			cerr << "Cannot load level " << startLevel << endl;
+			return 1;
+		}
+	}
+
+	  // the window has room for the delay and the jitter on top of it
+	int jitter = delay / 2;
+	RollbackSession session(rival, delay + jitter + 2);
+	LoopbackPeer link(delay, jitter, seed);
+	HeadlessHost player("", seed);
+
+	double worstAdvance = 0;
+	double allAdvances = 0;
+	int status = GWSTATUS_CONTINUE_GAME;
+	int referenceStatus = GWSTATUS_CONTINUE_GAME;
+	long tick = 0;
+	auto start = chrono::steady_clock::now();
+	for (; tick < maxTicks && referenceStatus == GWSTATUS_CONTINUE_GAME; tick++)
+	{
+		int key = 0;
+		player.getLastKey(key);
+		link.send(tick, key);
+		referenceStatus = reference.run(&key, 1, 1).status;
+
+		link.deliver(tick, session);
+		auto advanceStart = chrono::steady_clock::now();
+		status = session.advance();
+		double advanceTime = chrono::duration<double>(chrono::steady_clock::now() - advanceStart).count();
+		worstAdvance = max(worstAdvance, advanceTime);
+		allAdvances += advanceTime;
+	}
+	double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+	  // once every key is in, the rolled back world must have caught up exactly
+	link.deliver(tick + delay + jitter, session);
+	status = session.resimulate();
+	bool matched = status == referenceStatus && rival.getScore() == reference.getScore()
+		&& (status != GWSTATUS_CONTINUE_GAME || rival.getStateHash() == reference.getStateHash());
+
+	cout << tick << " ticks with keys " << delay << " +/- " << jitter << " ticks late: " << session.getRollbacks()
+		<< " rollbacks replaying " << session.getReplayedTicks() << " ticks, " << session.getDroppedKeys()
+		<< " keys dropped" << endl;
+	cout << "final status: " << statusName(status) << ", score " << rival.getScore() << ", "
+		<< (matched ? "matches" : "DIFFERS FROM") << " the world given every key on time" << endl;
+	cout << "ticks took " << (tick > 0 ? allAdvances / tick * 1e6 : 0) << " us on average with rollbacks, "
+		<< worstAdvance * 1e6 << " us at worst, " << seconds << " s in all" << endl;
+	return matched ? 0 : 1;
+}
+
+int main(int argc, char* argv[])
+{
+	if (argc < 2)
+		return usage();
+	string assetPath = argv[1];
+	if (!assetPath.empty() && assetPath.back() != '/')
+		assetPath += '/';
+
+	int startLevel = 1;
+	long maxTicks = 100000;
+	string script;
+	unsigned int seed = 1;
+	bool allLevels = false;
+	int batchWorlds = 0;
+	unsigned int batchThreads = 0;
+	string socketPath;
+	string sharedMemoryName;
+	int rollbackDelay = -1;
+	ReplayOptions replayOptions;
+	for (int i = 2; i < argc; i++)
+	{
+		string option = argv[i];
+		if (option == "-a")
+			allLevels = true;
+		else if (i + 1 >= argc)
+			return usage();
+		else if (option == "-l")
+			startLevel = atoi(argv[++i]);
+		else if (option == "-t")
+			maxTicks = atol(argv[++i]);
+		else if (option == "-k")
+			script = argv[++i];
+		else if (option == "-s")
+			seed = (unsigned int)strtoul(argv[++i], nullptr, 10);
+		else if (option == "-b")
+			batchWorlds = atoi(argv[++i]);
+		else if (option == "-j")
+			batchThreads = (unsigned int)strtoul(argv[++i], nullptr, 10);
+		else if (option == "-f")
+			socketPath = argv[++i];
+		else if (option == "-m")
+			sharedMemoryName = argv[++i];
+		else if (option == "-r")
+			rollbackDelay = atoi(argv[++i]);
+		else if (!replayOptions.parse(i, argc, argv))
+			return usage();
+	}
+
+	{
+		ifstream ifs(assetPath + "level01.txt");
+		if (!ifs)
+		{
+			cerr << "Cannot find level01.txt in " << assetPath << endl;
+			return 1;
+		}
+	}
+
+	if (rollbackDelay >= 0)
+		return runRollback(assetPath, startLevel, maxTicks, seed, rollbackDelay);
+	if (!sharedMemoryName.empty())
+	{
+		SharedMemoryServer server(assetPath, batchWorlds > 0 ? batchWorlds : 1, startLevel, seed, batchThreads);
+		return server.serve(sharedMemoryName) ? 0 : 1;
+	}
+	if (batchWorlds > 0)
+		return runBatch(assetPath, batchWorlds, batchThreads, startLevel, maxTicks, seed);
+	if (!socketPath.empty())
+	{
+		ForkServer server(assetPath, startLevel, seed);
+		return server.serve(socketPath) ? 0 : 1;
+	}
+
+	HeadlessHost host(script, seed);
+	StudentWorld* gw = new StudentWorld(assetPath);
+	gw->setController(&host);
+	gw->setTerrainShared(true);
+	gw->setSeed(seed);
+	for (int level = 1; level < startLevel; level++)
+		gw->advanceToNextLevel();
+
+	ReplayRecorder recorder;
+	if (!replayOptions.recordPath.empty())
+		gw->setReplayRecorder(&recorder);
+	Replay replay;
+	ReplayPlayer player(replay, replayOptions.startTick);
+	if (!replayOptions.playPath.empty())
+	{
+		if (!replay.load(replayOptions.playPath))
+		{
+			cerr << "Cannot read replay " << replayOptions.playPath << endl;
+			return 1;
+		}
+		  // the replay knows the levels it covers, and its keyframes where the world starts
+		gw->setReplayPlayer(&player);
+		allLevels = true;
+	}
+
+	  // the same transitions GameController makes, minus the prompts and animation
+	long ticks = 0;
+	int status = gw->init();
+	auto start = chrono::steady_clock::now();
+	while (status != GWSTATUS_LEVEL_ERROR && status != GWSTATUS_PLAYER_WON && ticks < maxTicks && !host.hasQuit()
+		&& (replayOptions.playPath.empty() || !player.atEnd()))
+	{
+		status = gw->move();
+		ticks++;
+		if (status == GWSTATUS_CONTINUE_GAME)
+			continue;
+
+		cout << "level " << gw->getLevel() << ": " << statusName(status) << " after " << ticks << " ticks" << endl;
+		if (status == GWSTATUS_PLAYER_DIED && gw->isGameOver())
+			break;
+		if (status == GWSTATUS_FINISHED_LEVEL)
+		{
+			if (!allLevels)
+				break;
+			gw->advanceToNextLevel();
+		}
+		if (status == GWSTATUS_PLAYER_WON)
+			break;
+		gw->cleanUp();
+		status = gw->init();
+	}
+	double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+	cout << "final status: " << statusName(status) << ", level " << gw->getLevel() << ", score " << gw->getScore()
+		<< ", lives " << gw->getLives() << endl;
+	cout << ticks << " ticks in " << seconds << " s";
+	if (seconds > 0)
+		cout << " (" << (long)(ticks / seconds) << " ticks/sec)";
+	cout << endl;
+
+	if (!replayOptions.recordPath.empty())
+	{
+		const Replay& recorded = recorder.getReplay();
+		if (!recorded.save(replayOptions.recordPath))
+		{
+			cerr << "Cannot write replay " << replayOptions.recordPath << endl;
+			delete gw;
+			return 1;
+		}
+		cout << "recorded " << recorded.getTickCount() << " ticks with " << recorded.getKeyframes().size()
+			<< " keyframes to " << replayOptions.recordPath << endl;
+	}
+	if (!replayOptions.playPath.empty())
+	{
+		cout << "replayed to tick " << player.getTick() << " of " << replay.getTickCount() << ", ";
+		if (player.getDesyncTick() < 0)
+			cout << "matching every keyframe" << endl;
+		else
+			cout << "DIFFERING from the recording at tick " << player.getDesyncTick() << endl;
+	}
+
+	bool failed = status == GWSTATUS_LEVEL_ERROR || player.getDesyncTick() >= 0;
+	delete gw;
+	return failed ? 1 : 0;
+}
@@ -0,0 +1,82 @@
+#include "LevelTemplate.h"
+#include "ActorDispatch.h"
+#include <map>
+#include <mutex>
+using namespace std;
+
+static const InteractionMasks s_categories = makeCategories(AllActorTypes());
+static const ObservationChannels s_observationChannels = makeObservationChannels(AllActorTypes());
+
+static bool kindFor(Level::GridEntry entry, ActorKind& kind)
+{
+	switch (entry)
+	{
+	case Level::GridEntry::block:                 kind = KIND_BLOCK; return true;
+	case Level::GridEntry::star_goodie_block:     kind = KIND_STAR_BLOCK; return true;
+	case Level::GridEntry::flower_goodie_block:   kind = KIND_FLOWER_BLOCK; return true;
+	case Level::GridEntry::mushroom_goodie_block: kind = KIND_MUSHROOM_BLOCK; return true;
+	case Level::GridEntry::pipe:                  kind = KIND_PIPE; return true;
+	case Level::GridEntry::koopa:                 kind = KIND_KOOPA; return true;
+	case Level::GridEntry::goomba:                kind = KIND_GOOMBA; return true;
+	case Level::GridEntry::piranha:               kind = KIND_PIRANHA; return true;
+	case Level::GridEntry::peach:                 kind = KIND_PEACH; return true;
+	case Level::GridEntry::flag:                  kind = KIND_FLAG; return true;
+	case Level::GridEntry::mario:                 kind = KIND_MARIO; return true;
+	case Level::GridEntry::empty:                 break;
+	}
+	return false;
+}
+
+shared_ptr<const LevelTemplate> LevelTemplate::get(const string& assetPath, const string& fileName,
+	Level::LoadResult& result)
+{
+	static mutex s_lock;
+	static map<string, shared_ptr<const LevelTemplate>> s_templates;
+
+	string key = assetPath + '\n' + fileName;
+	lock_guard<mutex> lock(s_lock);
+	auto found = s_templates.find(key);
+	if (found != s_templates.end())
+	{
+		result = Level::load_success;
+		return found->second;
+	}
+
+	  // failures are not cached, so a level file that turns up later is still found
+	Level level(assetPath);
+	result = level.loadLevel(fileName);
+	if (result != Level::load_success)
+		return nullptr;
+	shared_ptr<LevelTemplate> levelTemplate(new LevelTemplate);
+	levelTemplate->build(level);
+	s_templates[key] = levelTemplate;
+	return levelTemplate;
+}
+
+void LevelTemplate::build(Level& level)
+{
+	for (int gy = 0; gy < GRID_HEIGHT; gy++)
+	{
+		m_terrainRows[gy] = 0;
+		for (int gx = 0; gx < GRID_WIDTH; gx++)
+			m_terrainEntries[gy][gx] = -1;
+	}
+
+	for (int gy = 0; gy < GRID_HEIGHT; gy++)
+	{
+		for (int gx = 0; gx < GRID_WIDTH; gx++)
+		{
+			ActorKind kind;
+			if (!kindFor(level.getContentsOf(gx, gy), kind))
+				continue;
+			if (s_categories[kind] == CATEGORY_TERRAIN)
+			{
+				  // every terrain kind blocks, so every terrain cell is solid
+				m_terrainRows[gy] |= (uint32_t)1 << gx;
+				m_terrainEntries[gy][gx] = (int16_t)m_entries.size();
+				m_terrainObservation.add(s_observationChannels[kind], gx * SPRITE_WIDTH, gy * SPRITE_HEIGHT);
+			}
+			m_entries.push_back(Entry{ kind, gx, gy });
+		}
+	}
+}
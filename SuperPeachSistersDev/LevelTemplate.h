@@ -0,0 +1,52 @@
+#ifndef LEVELTEMPLATE_H_
+#define LEVELTEMPLATE_H_
+
+#include "Level.h"
+#include "ActorKind.h"
+#include "ObservationGrid.h"
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+// A level file parsed once and shared read only by every world playing it: the roster of actors to build, the
+// terrain bitboard rows, which terrain entry sits in each cell, and the terrain layer of the observation grid.
+// Templates are cached for the life of the process, so thousands of worlds on one level hold one copy.
+//
+class LevelTemplate
+{
+public:
+	struct Entry
+	{
+		ActorKind kind;
+		int gx;
+		int gy;
+	};
+
+	// The template for a level file, loaded on first use; null with the reason in result if it cannot be loaded.
+	// Safe to call from several threads at once.
+	static std::shared_ptr<const LevelTemplate> get(const std::string& assetPath, const std::string& fileName,
+		Level::LoadResult& result);
+
+	// Every actor of the level in grid order, bottom row first; entry i is built with actor sequence i + 1,
+	// so worlds that skip some entries still number the rest as a world that builds them all
+	const std::vector<Entry>& getEntries() const { return m_entries; }
+
+	// Terrain cells as bitboard rows, and the index into getEntries() of the terrain at a cell, or -1
+	const uint32_t* getTerrainRows() const { return m_terrainRows; }
+	int getTerrainEntry(int gx, int gy) const { return m_terrainEntries[gy][gx]; }
+
+	// The observation grid with only the terrain in it
+	const ObservationGrid& getTerrainObservation() const { return m_terrainObservation; }
+
+private:
+	LevelTemplate() { }
+	void build(Level& level);
+
+	std::vector<Entry> m_entries;
+	uint32_t m_terrainRows[GRID_HEIGHT];
+	int16_t m_terrainEntries[GRID_HEIGHT][GRID_WIDTH];
+	ObservationGrid m_terrainObservation;
+};
+
+#endif // LEVELTEMPLATE_H_
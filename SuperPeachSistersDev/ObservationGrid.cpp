@@ -0,0 +1,100 @@
+#include "ObservationGrid.h"
+#include <cstring>
+#include <climits>
+using namespace std;
+
+bool ObservationGrid::cellAt(double x, double y, int& gx, int& gy)
+{
+	if (x < 0 || y < 0)
+	{
+		return false;
+	}
+	gx = (int)x / SPRITE_WIDTH;
+	gy = (int)y / SPRITE_HEIGHT;
+	return gx < GRID_WIDTH && gy < GRID_HEIGHT;
+}
+
+void ObservationGrid::copyCounts(const unsigned short* counts, int n, unsigned char* cells)
+{
+	for (int i = 0; i < n; i++)
+	{
+		cells[i] = counts[i] > UCHAR_MAX ? UCHAR_MAX : (unsigned char)counts[i];
+	}
+}
+
+void ObservationGrid::add(ObservationChannel channel, double x, double y)
+{
+	int gx, gy;
+	if (cellAt(x, y, gx, gy))
+	{
+		m_cells[channel][gy][gx]++;
+	}
+}
+
+void ObservationGrid::remove(ObservationChannel channel, double x, double y)
+{
+	int gx, gy;
+	if (cellAt(x, y, gx, gy))
+	{
+		m_cells[channel][gy][gx]--;
+	}
+}
+
+void ObservationGrid::move(ObservationChannel channel, double oldX, double oldY, double x, double y)
+{
+	// most steps stay within a cell
+	int oldGx = -1, oldGy = -1, gx = -1, gy = -1;
+	bool wasInside = cellAt(oldX, oldY, oldGx, oldGy);
+	bool isInside = cellAt(x, y, gx, gy);
+	if (wasInside == isInside && oldGx == gx && oldGy == gy)
+	{
+		return;
+	}
+	if (wasInside)
+	{
+		m_cells[channel][oldGy][oldGx]--;
+	}
+	if (isInside)
+	{
+		m_cells[channel][gy][gx]++;
+	}
+}
+
+void ObservationGrid::clear()
+{
+	memset(m_cells, 0, sizeof(m_cells));
+}
+
+void ObservationGrid::copyTo(unsigned char* cells) const
+{
+	copyCounts(&m_cells[0][0][0], SIZE, cells);
+}
+
+void ObservationGrid::copyEgocentricTo(double centreX, double centreY, unsigned char* cells) const
+{
+	memset(cells, 0, EGOCENTRIC_SIZE);
+
+	int cx = (int)centreX / SPRITE_WIDTH;
+	int cy = (int)centreY / SPRITE_HEIGHT;
+	int left = cx - EGOCENTRIC_WIDTH / 2;
+	int bottom = cy - EGOCENTRIC_HEIGHT / 2;
+
+	// the window clipped to the level, as a run of whole rows copied per channel
+	int firstX = left < 0 ? 0 : left;
+	int lastX = left + EGOCENTRIC_WIDTH > GRID_WIDTH ? GRID_WIDTH : left + EGOCENTRIC_WIDTH;
+	int firstY = bottom < 0 ? 0 : bottom;
+	int lastY = bottom + EGOCENTRIC_HEIGHT > GRID_HEIGHT ? GRID_HEIGHT : bottom + EGOCENTRIC_HEIGHT;
+	if (firstX >= lastX || firstY >= lastY)
+	{
+		return;
+	}
+
+	for (int channel = 0; channel < CHANNEL_COUNT; channel++)
+	{
+		unsigned char* window = cells + channel * EGOCENTRIC_HEIGHT * EGOCENTRIC_WIDTH;
+		for (int gy = firstY; gy < lastY; gy++)
+		{
+			copyCounts(&m_cells[channel][gy][firstX], lastX - firstX, window + (gy - bottom) * EGOCENTRIC_WIDTH + (firstX - left));
+		}
+	}
+}
@@ -0,0 +1,40 @@
+#ifndef OBSERVATIONGRID_H_
+#define OBSERVATIONGRID_H_
+
+#include "GameConstants.h"
+#include "ActorKind.h"
+
+// The world as agents see it: for each observation channel, a GRID_HEIGHT by GRID_WIDTH count of the actors of
+// that channel whose lower left corner lies in each cell, row 0 at the bottom. The world keeps it up to date as
+// actors are added, move between cells and are removed, so reading it is a copy whatever the number of actors.
+// Counts are kept wide and read out as bytes, a cell holding more than UCHAR_MAX actors reading UCHAR_MAX.
+//
+class ObservationGrid
+{
+public:
+	static const int SIZE = CHANNEL_COUNT * GRID_HEIGHT * GRID_WIDTH;
+
+	// The egocentric view: the same channels cropped to a window centred on a cell, cells off the level reading 0
+	static const int EGOCENTRIC_WIDTH = 15;
+	static const int EGOCENTRIC_HEIGHT = 15;
+	static const int EGOCENTRIC_SIZE = CHANNEL_COUNT * EGOCENTRIC_HEIGHT * EGOCENTRIC_WIDTH;
+
+	ObservationGrid() { clear(); }
+
+	void add(ObservationChannel channel, double x, double y);
+	void remove(ObservationChannel channel, double x, double y);
+	void move(ObservationChannel channel, double oldX, double oldY, double x, double y);
+	void clear();
+
+	const unsigned short* getCells() const { return &m_cells[0][0][0]; }
+	void copyTo(unsigned char* cells) const;
+	void copyEgocentricTo(double centreX, double centreY, unsigned char* cells) const;
+
+private:
+	static bool cellAt(double x, double y, int& gx, int& gy);
+	static void copyCounts(const unsigned short* counts, int n, unsigned char* cells);
+
+	unsigned short m_cells[CHANNEL_COUNT][GRID_HEIGHT][GRID_WIDTH];
+};
+
+#endif // OBSERVATIONGRID_H_
@@ -0,0 +1,21 @@
+#include "RenderRegistry.h"
+#include "GraphObject.h"
+using namespace std;
+
+void RenderRegistry::add(GraphObject* object, int depth)
+{
+	vector<GraphObject*>& layer = m_layers[layerFor(depth)];
+	object->m_registry = this;
+	object->m_renderIndex = layer.size();
+	layer.push_back(object);
+}
+
+void RenderRegistry::remove(GraphObject* object)
+{
+	vector<GraphObject*>& layer = m_layers[layerFor(object->m_depth)];
+	GraphObject* last = layer.back();
+	layer[object->m_renderIndex] = last;
+	last->m_renderIndex = object->m_renderIndex;
+	layer.pop_back();
+	object->m_registry = nullptr;
+}
@@ -0,0 +1,30 @@
+#ifndef RENDERREGISTRY_H_
+#define RENDERREGISTRY_H_
+
+#include <vector>
+#include <cstddef>
+
+class GraphObject;
+
+// The graph objects a world shows, one dense array per depth. Each object remembers its slot, so adding and
+// removing are O(1); removal moves the last object of the layer into the hole, so draw order within a depth
+// is arbitrary, as it always was. Every world owns one, so worlds in the same process never see each other's objects.
+//
+class RenderRegistry
+{
+public:
+	static const int NUM_DEPTHS = 4;
+
+	void add(GraphObject* object, int depth);
+	void remove(GraphObject* object);
+
+	const std::vector<GraphObject*>& getLayer(int depth) const { return m_layers[layerFor(depth)]; }
+
+private:
+	// depths past the last layer share the first, as they did with the old global sets
+	static int layerFor(int depth) { return (depth >= 0 && depth < NUM_DEPTHS) ? depth : 0; }
+
+	std::vector<GraphObject*> m_layers[NUM_DEPTHS];
+};
+
+#endif // RENDERREGISTRY_H_
@@ -0,0 +1,248 @@
+#include "Replay.h"
+#include "StudentWorld.h"
+#include "WorldSnapshot.h"
+#include "GameConstants.h"
+#include <fstream>
+#include <iterator>
+#include <algorithm>
+#include <cstdlib>
+using namespace std;
+
+int Replay::getKey(long tick) const
+{
+	  // the last run starting at or before the tick
+	auto run = upper_bound(m_runs.begin(), m_runs.end(), tick,
+		[](long value, const Run& entry) { return value < entry.start; });
+	if (run == m_runs.begin() || tick >= m_tickCount)
+		return 0;
+	return (run - 1)->key;
+}
+
+const Replay::Keyframe* Replay::findKeyframe(long tick) const
+{
+	auto keyframe = upper_bound(m_keyframes.begin(), m_keyframes.end(), tick,
+		[](long value, const Keyframe& entry) { return value < entry.tick; });
+	if (keyframe == m_keyframes.begin())
+		return nullptr;
+	return &*(keyframe - 1);
+}
+
+void Replay::write(vector<unsigned char>& bytes) const
+{
+	SnapshotWriter writer(bytes);
+	writer.putU32(REPLAY_MAGIC);
+	writer.putU16(REPLAY_VERSION);
+	writer.putU16(m_startLevel);
+	writer.putU64(m_seed);
+	writer.putU32(m_keyframeInterval);
+	writer.putU32((uint32_t)m_tickCount);
+
+	  // runs too long for their count are split, so the file may hold more runs than memory does
+	vector<pair<int, long>> runs;
+	for (size_t i = 0; i < m_runs.size(); i++)
+	{
+		long end = (i + 1 < m_runs.size() ? m_runs[i + 1].start : m_tickCount);
+		for (long start = m_runs[i].start; start < end; start += 0xffff)
+			runs.push_back(make_pair(m_runs[i].key, min(end - start, 0xffffL)));
+	}
+	writer.putU32((uint32_t)runs.size());
+	for (const pair<int, long>& run : runs)
+	{
+		writer.putU16(run.first);
+		writer.putU16((unsigned)run.second);
+	}
+
+	writer.putU32((uint32_t)m_keyframes.size());
+	for (const Keyframe& keyframe : m_keyframes)
+	{
+		writer.putU32((uint32_t)keyframe.tick);
+		writer.putU32((uint32_t)keyframe.state.size());
+		bytes.insert(bytes.end(), keyframe.state.begin(), keyframe.state.end());
+	}
+}
+
+bool Replay::read(const unsigned char* bytes, size_t size)
+{
+	SnapshotReader reader(bytes, size);
+	if (reader.getU32() != REPLAY_MAGIC || reader.getU16() != REPLAY_VERSION)
+		return false;
+	m_startLevel = reader.getU16();
+	m_seed = reader.getU64();
+	m_keyframeInterval = (int)reader.getU32();
+	m_tickCount = reader.getU32();
+
+	m_runs.clear();
+	long tick = 0;
+	for (uint32_t count = reader.getU32(); count > 0 && !reader.failed(); count--)
+	{
+		int key = reader.getU16();
+		long length = reader.getU16();
+		  // split runs join up again
+		if (m_runs.empty() || m_runs.back().key != key)
+			m_runs.push_back(Run{ tick, key });
+		tick += length;
+	}
+	if (tick != m_tickCount)
+		return false;
+
+	m_keyframes.clear();
+	for (uint32_t count = reader.getU32(); count > 0 && !reader.failed(); count--)
+	{
+		Keyframe keyframe;
+		keyframe.tick = reader.getU32();
+		uint32_t stateSize = reader.getU32();
+		size_t offset = reader.skip(stateSize);
+		if (reader.failed() || (!m_keyframes.empty() && keyframe.tick <= m_keyframes.back().tick))
+			return false;
+		keyframe.state.assign(bytes + offset, bytes + offset + stateSize);
+		m_keyframes.push_back(move(keyframe));
+	}
+	return !reader.failed() && reader.atEnd();
+}
+
+bool Replay::save(const string& path) const
+{
+	vector<unsigned char> bytes;
+	write(bytes);
+	ofstream ofs(path, ios::binary);
+	ofs.write(reinterpret_cast<const char*>(bytes.data()), bytes.size());
+	return ofs.good();
+}
+
+bool Replay::load(const string& path)
+{
+	ifstream ifs(path, ios::binary);
+	if (!ifs)
+		return false;
+	vector<unsigned char> bytes((istreambuf_iterator<char>(ifs)), istreambuf_iterator<char>());
+	return read(bytes.data(), bytes.size());
+}
+
+bool ReplayOptions::parse(int& i, int argc, char* argv[])
+{
+	if (i + 1 >= argc)
+		return false;
+	string option = argv[i];
+	if (option == "-w")
+		recordPath = argv[++i];
+	else if (option == "-p")
+		playPath = argv[++i];
+	else if (option == "-g")
+		startTick = atol(argv[++i]);
+	else
+		return false;
+	return true;
+}
+
+ReplayRecorder::ReplayRecorder(int keyframeInterval)
+{
+	m_replay.m_keyframeInterval = max(keyframeInterval, 1);
+}
+
+void ReplayRecorder::appendKey(int key)
+{
+	if (m_replay.m_runs.empty() || m_replay.m_runs.back().key != key)
+		m_replay.m_runs.push_back(Replay::Run{ m_replay.m_tickCount, key });
+	m_replay.m_tickCount++;
+}
+
+void ReplayRecorder::beginTick(const StudentWorld& world)
+{
+	if (m_tickPending)
+		appendKey(m_key);
+	else if (m_replay.m_tickCount == 0)
+	{
+		m_replay.m_startLevel = world.getLevel();
+		m_replay.m_seed = world.getSeed();
+	}
+	m_tickPending = true;
+	m_key = 0;
+
+	long tick = m_replay.m_tickCount;
+	if (tick % m_replay.m_keyframeInterval == 0)
+	{
+		Replay::Keyframe keyframe;
+		keyframe.tick = tick;
+		if (world.saveSnapshot(keyframe.state))
+			m_replay.m_keyframes.push_back(move(keyframe));
+	}
+}
+
+const Replay& ReplayRecorder::getReplay()
+{
+	if (m_tickPending)
+	{
+		appendKey(m_key);
+		m_tickPending = false;
+	}
+	return m_replay;
+}
+
+bool ReplayPlayer::seek(StudentWorld& world, long tick)
+{
+	tick = max(0L, min(tick, m_replay.getTickCount() - 1));
+	const Replay::Keyframe* keyframe = m_replay.findKeyframe(tick);
+	if (keyframe == nullptr)
+	{
+		world.cleanUp();
+		return false;
+	}
+	if (!world.restoreSnapshot(keyframe->state.data(), keyframe->state.size()))
+		return false;
+	world.setReplayPlayer(this);
+	m_started = true;
+	m_tick = keyframe->tick;
+
+	  // the same transitions GameController makes, with nothing shown or heard on the way
+	bool silent = world.isSilent();
+	world.setSilent(true);
+	int status = GWSTATUS_CONTINUE_GAME;
+	while (m_tick < tick && status == GWSTATUS_CONTINUE_GAME)
+	{
+		status = world.move();
+		if (status == GWSTATUS_PLAYER_DIED && !world.isGameOver())
+		{
+			world.cleanUp();
+			status = world.init();
+		}
+		else if (status == GWSTATUS_FINISHED_LEVEL)
+		{
+			world.advanceToNextLevel();
+			world.cleanUp();
+			status = world.init();
+		}
+	}
+	world.setSilent(silent);
+
+	  // the recording goes on past the tick, so a game that ends or a level that will not load before it has drifted
+	if (status != GWSTATUS_CONTINUE_GAME)
+	{
+		world.cleanUp();
+		return false;
+	}
+	return true;
+}
+
+bool ReplayPlayer::levelStarted(StudentWorld& world)
+{
+	if (m_started || m_replay.getTickCount() == 0)
+		return true;
+	m_started = true;
+	return seek(world, m_startTick);
+}
+
+void ReplayPlayer::beginTick(const StudentWorld& world)
+{
+	m_tickRecorded = !atEnd();
+	m_key = m_replay.getKey(m_tick);
+
+	  // every keyframe passed is a check that the world is still where the recording was
+	const Replay::Keyframe* keyframe = m_replay.findKeyframe(m_tick);
+	if (m_tickRecorded && m_desyncTick < 0 && keyframe != nullptr && keyframe->tick == m_tick)
+	{
+		world.saveSnapshot(m_state);
+		if (m_state != keyframe->state)
+			m_desyncTick = m_tick;
+	}
+	m_tick++;
+}
@@ -0,0 +1,146 @@
+#ifndef REPLAY_H_
+#define REPLAY_H_
+
+#include <string>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+class StudentWorld;
+
+// A recorded game: the key read on every tick, counted across lives and levels from the first move(), and a
+// snapshot of the world (see StudentWorld::saveSnapshot) taken before every keyframeInterval-th tick. Play is
+// deterministic, so the keys alone replay the game; the keyframes let a viewer start anywhere after replaying at
+// most keyframeInterval ticks, and let playback check it has not drifted from what was recorded.
+//
+// File format version 1, integers little endian as in WorldSnapshot.h:
+//
+//   u32 magic, u16 version, u16 start level, u64 seed, u32 keyframe interval, u32 tick count
+//   u32 count, then runs of ticks reading the same key: u16 key (0 for none), u16 ticks
+//   u32 count, then keyframes in tick order: u32 tick, u32 size, then that many bytes of snapshot
+//
+const uint32_t REPLAY_MAGIC = 0x50525053;	// "SPRP"
+const uint16_t REPLAY_VERSION = 1;
+const int DEFAULT_KEYFRAME_INTERVAL = 256;
+
+class Replay
+{
+public:
+	struct Keyframe
+	{
+		long tick;
+		std::vector<unsigned char> state;
+	};
+
+	int getStartLevel() const { return m_startLevel; }
+	uint64_t getSeed() const { return m_seed; }
+	int getKeyframeInterval() const { return m_keyframeInterval; }
+	long getTickCount() const { return m_tickCount; }
+	const std::vector<Keyframe>& getKeyframes() const { return m_keyframes; }
+
+	// The key read on a tick, 0 for none
+	int getKey(long tick) const;
+	// The latest keyframe at or before a tick, or null if there is none
+	const Keyframe* findKeyframe(long tick) const;
+
+	void write(std::vector<unsigned char>& bytes) const;
+	bool read(const unsigned char* bytes, size_t size);
+	bool save(const std::string& path) const;
+	bool load(const std::string& path);
+
+private:
+	friend class ReplayRecorder;
+
+	// a run of ticks from start reading the same key; runs are kept whole in memory and split only in the file
+	struct Run
+	{
+		long start;
+		int key;
+	};
+
+	int m_startLevel = 1;
+	uint64_t m_seed = 0;
+	int m_keyframeInterval = DEFAULT_KEYFRAME_INTERVAL;
+	long m_tickCount = 0;
+	std::vector<Run> m_runs;
+	std::vector<Keyframe> m_keyframes;
+};
+
+// Records the game a world plays while it is set as the world's recorder (see StudentWorld::setReplayRecorder)
+class ReplayRecorder
+{
+public:
+	ReplayRecorder(int keyframeInterval = DEFAULT_KEYFRAME_INTERVAL);
+
+	// Called by the world before each tick, and with the key it reads during the tick
+	void beginTick(const StudentWorld& world);
+	void keyRead(int key) { m_key = key; }
+
+	// The game so far, up to the last tick begun; call it between ticks
+	const Replay& getReplay();
+	bool save(const std::string& path) { return getReplay().save(path); }
+
+private:
+	void appendKey(int key);
+
+	Replay m_replay;
+	bool m_tickPending = false;		// a tick has begun whose key is not yet in a run
+	int m_key = 0;
+};
+
+// Plays a replay in a world while it is set as the world's player (see StudentWorld::setReplayPlayer): each tick
+// reads its recorded key in place of the host's, and once the recorded ticks run out the host takes over. The
+// first level the world starts jumps straight to the start tick, so the GLUT game and headless runs alike begin
+// there after the world's first init().
+//
+class ReplayPlayer
+{
+public:
+	ReplayPlayer(const Replay& replay, long startTick = 0) : m_replay(replay), m_startTick(startTick) { }
+
+	// Leaves the world before the given tick (clamped to the recording): restores the latest keyframe at or
+	// before it, then replays the ticks in between silently, starting lives and levels as the game did, with this
+	// set as the world's player. False, leaving the world cleaned up, if there is no keyframe, it does not restore,
+	// or the game ends or a level fails to start on the way.
+	bool seek(StudentWorld& world, long tick);
+
+	// Called by the world as each level starts (false if the jump to the start tick fails), before each tick, and
+	// for the key to read during the tick
+	bool levelStarted(StudentWorld& world);
+	void beginTick(const StudentWorld& world);
+	bool isTickRecorded() const { return m_tickRecorded; }
+	int getKey() const { return m_key; }
+
+	// The next tick to play, and whether the recording has run out by then
+	long getTick() const { return m_tick; }
+	bool atEnd() const { return m_tick >= m_replay.getTickCount(); }
+	// The first tick whose world did not match its keyframe, or -1 while every keyframe has matched
+	long getDesyncTick() const { return m_desyncTick; }
+
+private:
+	const Replay& m_replay;
+	long m_startTick;
+	bool m_started = false;
+	long m_tick = 0;
+	bool m_tickRecorded = false;
+	int m_key = 0;
+	long m_desyncTick = -1;
+	std::vector<unsigned char> m_state;
+};
+
+// The replay options the GLUT game and headless runs share:
+//   -w replayFile   records the game to a replay file when it ends
+//   -p replayFile   plays a replay back from its start level and seed
+//   -g tick         starts the replay at that tick
+struct ReplayOptions
+{
+	std::string recordPath;
+	std::string playPath;
+	long startTick = 0;
+
+	// Consumes the option at argv[i] and its value, leaving i at the value; false if it is not one of these or
+	// has no value
+	bool parse(int& i, int argc, char* argv[]);
+};
+
+#endif // REPLAY_H_
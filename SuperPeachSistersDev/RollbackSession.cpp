@@ -0,0 +1,113 @@
+#include "RollbackSession.h"
+#include "StudentWorld.h"
+#include "WorldRandom.h"
+#include "GameConstants.h"
+#include <algorithm>
+using namespace std;
+
+RollbackSession::RollbackSession(StudentWorld& world, int window)
+ : m_world(world), m_window(window), m_states(window), m_inputs(2 * window), m_status(GWSTATUS_CONTINUE_GAME)
+{
+}
+
+RollbackSession::TickInput& RollbackSession::inputFor(long tick)
+{
+	TickInput& input = m_inputs[tick % m_inputs.size()];
+	if (input.tick != tick)
+		input = TickInput();
+	input.tick = tick;
+	return input;
+}
+
+void RollbackSession::confirmKey(long tick, int key)
+{
+	  // ticks before the window have lost their states, and ticks too far ahead have no input slot yet
+	if (tick < m_tick - m_window || tick >= m_tick + m_window)
+	{
+		m_droppedKeys++;
+		return;
+	}
+
+	TickInput& input = inputFor(tick);
+	input.key = key;
+	input.confirmed = true;
+	if (tick > m_latestConfirmed)
+	{
+		m_latestConfirmed = tick;
+		m_predictedKey = key;
+	}
+	if (input.played && input.playedKey != key && (m_rollbackFrom < 0 || tick < m_rollbackFrom))
+		m_rollbackFrom = tick;
+}
+
+int RollbackSession::playTick(long tick)
+{
+	TickInput& input = inputFor(tick);
+	int key = input.confirmed ? input.key : m_predictedKey;
+	input.played = true;
+	input.playedKey = key;
+	m_world.saveSnapshot(m_states[tick % m_window]);
+	return m_world.run(&key, 1, 1).status;
+}
+
+int RollbackSession::resimulate()
+{
+	if (m_rollbackFrom < 0)
+		return m_status;
+
+	  // replayed ticks are not shown, so from the restore on they make no sound and leave the status line alone
+	bool silent = m_world.isSilent();
+	m_world.setSilent(true);
+	const vector<unsigned char>& state = m_states[m_rollbackFrom % m_window];
+	if (!m_world.restoreSnapshot(state.data(), state.size()))
+	{
+		  // the world has been cleaned up, so there is nothing left to play
+		m_world.setSilent(silent);
+		m_rollbackFrom = -1;
+		m_status = GWSTATUS_LEVEL_ERROR;
+		return m_status;
+	}
+	for (long tick = m_rollbackFrom; tick < m_tick; tick++)
+		inputFor(tick).played = false;
+
+	m_status = GWSTATUS_CONTINUE_GAME;
+	for (long tick = m_rollbackFrom; tick < m_tick && m_status == GWSTATUS_CONTINUE_GAME; tick++)
+	{
+		m_status = playTick(tick);
+		m_replayedTicks++;
+	}
+	m_world.setSilent(silent);
+	m_rollbackFrom = -1;
+	m_rollbacks++;
+	return m_status;
+}
+
+int RollbackSession::advance()
+{
+	if (resimulate() == GWSTATUS_CONTINUE_GAME)
+		m_status = playTick(m_tick);
+	m_tick++;
+	return m_status;
+}
+
+void LoopbackPeer::send(long tick, int key)
+{
+	long arrival = tick + m_delay;
+	if (m_jitter > 0)
+		arrival += WorldRandom(m_seed).randInt(0, tick, -m_jitter, m_jitter);
+	  // the link keeps keys in order, so none overtakes one sent before it
+	if (!m_inFlight.empty())
+		arrival = max(arrival, m_inFlight.back().arrival);
+	m_inFlight.push_back(Packet{ tick, key, max(arrival, tick) });
+}
+
+void LoopbackPeer::deliver(long now, RollbackSession& session)
+{
+	size_t delivered = 0;
+	while (delivered < m_inFlight.size() && m_inFlight[delivered].arrival <= now)
+	{
+		session.confirmKey(m_inFlight[delivered].tick, m_inFlight[delivered].key);
+		delivered++;
+	}
+	m_inFlight.erase(m_inFlight.begin(), m_inFlight.begin() + delivered);
+}
@@ -0,0 +1,94 @@
+#ifndef ROLLBACKSESSION_H_
+#define ROLLBACKSESSION_H_
+
+#include <vector>
+
+class StudentWorld;
+
+// Plays a world whose keys come from a remote player and arrive late. Each tick uses the key confirmed for it,
+// or a prediction, the last key confirmed, when it has not come yet. When a confirmed key turns out to differ
+// from the one a past tick was played with, the session restores the world to that tick and replays up to the
+// present with the keys now known, silently, so the player only ever sees the corrected present.
+//
+// The world state before each of the last window ticks is kept as a snapshot in a ring; keys for ticks older
+// than that can no longer be rolled back and are dropped, so the window must exceed the worst input delay.
+//
+class RollbackSession
+{
+public:
+	RollbackSession(StudentWorld& world, int window = 16);
+
+	// The key the remote player pressed on a tick counted from the session's start (a KEY_PRESS_ value, or 0)
+	void confirmKey(long tick, int key);
+
+	// Rolls back and replays if a confirmed key contradicts a prediction, then plays the next tick; returns its
+	// status. Once a tick ends the life or level, later ticks still pass but are not played, and that status is
+	// returned until a rollback undoes the ending.
+	int advance();
+
+	// Replays a pending rollback without playing a new tick; returns the status of the last tick replayed, or
+	// of the present tick if there was nothing to replay. If the saved state fails to restore, the session stops
+	// there and reports a level error from then on.
+	int resimulate();
+
+	long getTick() const { return m_tick; }
+	long getRollbacks() const { return m_rollbacks; }
+	long getReplayedTicks() const { return m_replayedTicks; }
+	long getDroppedKeys() const { return m_droppedKeys; }
+
+private:
+	struct TickInput
+	{
+		long tick = -1;
+		int key = 0;			// as confirmed
+		bool confirmed = false;
+		bool played = false;	// in the present timeline
+		int playedKey = 0;
+	};
+
+	TickInput& inputFor(long tick);
+	int playTick(long tick);
+
+	StudentWorld& m_world;
+	int m_window;
+	std::vector<std::vector<unsigned char>> m_states;	// before tick t at t % window
+	std::vector<TickInput> m_inputs;					// for tick t at t % (2 * window)
+	long m_tick = 0;									// the present tick
+	long m_rollbackFrom = -1;							// the earliest tick played with a wrong key
+	int m_predictedKey = 0;								// the key of the latest tick confirmed
+	long m_latestConfirmed = -1;
+	int m_status;
+
+	long m_rollbacks = 0;
+	long m_replayedTicks = 0;
+	long m_droppedKeys = 0;
+};
+
+// Stands in for the network between two peers: keys sent for a tick are delivered delay ticks later, give or
+// take up to jitter ticks drawn from a seeded generator, but never before a key sent earlier
+//
+class LoopbackPeer
+{
+public:
+	LoopbackPeer(int delay, int jitter = 0, unsigned long long seed = 0)
+		: m_delay(delay), m_jitter(jitter), m_seed(seed) { }
+
+	void send(long tick, int key);
+	// Hands every key due by the given tick to the session
+	void deliver(long now, RollbackSession& session);
+
+private:
+	struct Packet
+	{
+		long tick;
+		int key;
+		long arrival;
+	};
+
+	int m_delay;
+	int m_jitter;
+	unsigned long long m_seed;
+	std::vector<Packet> m_inFlight;
+};
+
+#endif // ROLLBACKSESSION_H_
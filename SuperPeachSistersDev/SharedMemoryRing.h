@@ -0,0 +1,79 @@
+#ifndef SHAREDMEMORYRING_H_
+#define SHAREDMEMORYRING_H_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+// Ring indices for one producer and one consumer in different processes. Both only ever grow; the slot for
+// index n is n % capacity. Each sits on its own cache line so the two sides never write the same line.
+struct RingIndices
+{
+	alignas(64) std::atomic<uint64_t> head;		// slots published, bumped by the producer
+	alignas(64) std::atomic<uint64_t> tail;		// slots released, bumped by the consumer
+};
+
+static_assert(std::atomic<uint64_t>::is_always_lock_free, "ring indices must work across processes");
+
+// A lock free single producer, single consumer ring of fixed size slots over memory the caller owns, usually a
+// shared memory segment. Slots are filled and read in place: the producer takes writeSlot(), fills it and
+// publishes it; the consumer takes readSlot(), reads it and releases it. Each side keeps its own copy of the
+// other's index and only rereads the shared one when the ring looks full or empty.
+//
+class SpscRing
+{
+public:
+	SpscRing() { }
+	SpscRing(RingIndices* indices, unsigned char* slots, size_t slotSize, uint32_t capacity)
+	 : m_indices(indices), m_slots(slots), m_slotSize(slotSize), m_capacity(capacity)
+	{
+		m_head = indices->head.load(std::memory_order_relaxed);
+		m_tail = indices->tail.load(std::memory_order_relaxed);
+	}
+
+	// Producer: the next slot to fill, or null while the ring is full
+	unsigned char* writeSlot()
+	{
+		if (m_head - m_tail == m_capacity)
+		{
+			m_tail = m_indices->tail.load(std::memory_order_acquire);
+			if (m_head - m_tail == m_capacity)
+				return nullptr;
+		}
+		return slot(m_head);
+	}
+	void publish()
+	{
+		m_head++;
+		m_indices->head.store(m_head, std::memory_order_release);
+	}
+
+	// Consumer: the oldest slot not yet released, or null while the ring is empty
+	const unsigned char* readSlot()
+	{
+		if (m_tail == m_head)
+		{
+			m_head = m_indices->head.load(std::memory_order_acquire);
+			if (m_tail == m_head)
+				return nullptr;
+		}
+		return slot(m_tail);
+	}
+	void release()
+	{
+		m_tail++;
+		m_indices->tail.store(m_tail, std::memory_order_release);
+	}
+
+private:
+	unsigned char* slot(uint64_t index) const { return m_slots + (index % m_capacity) * m_slotSize; }
+
+	RingIndices* m_indices = nullptr;
+	unsigned char* m_slots = nullptr;
+	size_t m_slotSize = 0;
+	uint32_t m_capacity = 0;
+	uint64_t m_head = 0;
+	uint64_t m_tail = 0;
+};
+
+#endif // SHAREDMEMORYRING_H_
@@ -0,0 +1,188 @@
+#include "SharedMemoryServer.h"
+#include "StudentWorld.h"
+#include "GameConstants.h"
+#include <iostream>
+#include <thread>
+#include <new>
+#include <cerrno>
+#include <cstring>
+#include <chrono>
+#include <algorithm>
+#include <csignal>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+using namespace std;
+
+static size_t alignUp(size_t size, size_t alignment)
+{
+	return (size + alignment - 1) / alignment * alignment;
+}
+
+  // Waits a little after the waits-th failed look at the rings: spins for a trainer keeping up, which answers in
+  // microseconds, then yields, then sleeps from a microsecond doubling up to about a millisecond
+static void backOff(int waits)
+{
+	const int SPINS = 1000;
+	const int YIELDS = 100;
+	if (waits < SPINS)
+		return;
+	if (waits < SPINS + YIELDS)
+		this_thread::yield();
+	else
+		this_thread::sleep_for(chrono::microseconds(1 << min(waits - SPINS - YIELDS, 10)));
+}
+
+SharedMemoryServer::SharedMemoryServer(string assetPath, int worldCount, int startLevel, uint64_t seed,
+	unsigned int threadCount)
+ : m_env(assetPath, worldCount, startLevel, seed, threadCount)
+{
+}
+
+SharedMemoryServer::~SharedMemoryServer()
+{
+	destroy();
+}
+
+bool SharedMemoryServer::create(const string& name)
+{
+	size_t worldCount = m_env.getWorldCount();
+	size_t statusesOffset = sizeof(uint64_t);
+	size_t rewardsOffset = statusesOffset + worldCount * sizeof(int32_t);
+	size_t donesOffset = rewardsOffset + worldCount * sizeof(int32_t);
+	size_t observationsOffset = alignUp(donesOffset + worldCount, 64);
+	size_t frameSize = alignUp(observationsOffset + worldCount * StudentWorld::OBSERVATION_SIZE, 64);
+	size_t actionSize = alignUp(worldCount * sizeof(int32_t), 64);
+	size_t framesOffset = alignUp(sizeof(Header), 64);
+	size_t actionsOffset = framesOffset + FRAME_CAPACITY * frameSize;
+	size_t segmentSize = actionsOffset + ACTION_CAPACITY * actionSize;
+
+	  // a segment left under the name may belong to a running server, so it is never taken over
+	int fd = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+	if (fd < 0)
+	{
+		cerr << "Cannot create shared memory " << name << ": " << strerror(errno) << endl;
+		if (errno == EEXIST)
+			cerr << "Another server may be using it; if none is, remove /dev/shm" << name << endl;
+		return false;
+	}
+	void* segment = MAP_FAILED;
+	if (ftruncate(fd, segmentSize) == 0)
+		segment = mmap(nullptr, segmentSize, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	close(fd);
+	if (segment == MAP_FAILED)
+	{
+		cerr << "Cannot map shared memory " << name << ": " << strerror(errno) << endl;
+		shm_unlink(name.c_str());
+		return false;
+	}
+
+	m_name = name;
+	m_segment = static_cast<unsigned char*>(segment);
+	m_segmentSize = segmentSize;
+	m_header = new (m_segment) Header;
+	m_header->magic.store(0, memory_order_relaxed);
+	m_header->version = VERSION;
+	m_header->worldCount = (uint32_t)worldCount;
+	m_header->observationSize = StudentWorld::OBSERVATION_SIZE;
+	m_header->frameCapacity = FRAME_CAPACITY;
+	m_header->actionCapacity = ACTION_CAPACITY;
+	m_header->frameSize = frameSize;
+	m_header->actionSize = actionSize;
+	m_header->framesOffset = framesOffset;
+	m_header->actionsOffset = actionsOffset;
+	m_header->statusesOffset = statusesOffset;
+	m_header->rewardsOffset = rewardsOffset;
+	m_header->donesOffset = donesOffset;
+	m_header->observationsOffset = observationsOffset;
+	m_header->closed.store(0, memory_order_relaxed);
+	m_header->trainerPid.store(0, memory_order_relaxed);
+	m_header->frames.head.store(0, memory_order_relaxed);
+	m_header->frames.tail.store(0, memory_order_relaxed);
+	m_header->actions.head.store(0, memory_order_relaxed);
+	m_header->actions.tail.store(0, memory_order_relaxed);
+
+	m_frames = SpscRing(&m_header->frames, m_segment + framesOffset, frameSize, FRAME_CAPACITY);
+	m_actions = SpscRing(&m_header->actions, m_segment + actionsOffset, actionSize, ACTION_CAPACITY);
+	return true;
+}
+
+void SharedMemoryServer::destroy()
+{
+	if (m_segment == nullptr)
+		return;
+	munmap(m_segment, m_segmentSize);
+	shm_unlink(m_name.c_str());
+	m_segment = nullptr;
+	m_header = nullptr;
+}
+
+bool SharedMemoryServer::isTrainerGone() const
+{
+	pid_t pid = m_header->trainerPid.load(memory_order_relaxed);
+	return pid > 0 && kill(pid, 0) != 0 && errno == ESRCH;
+}
+
+void SharedMemoryServer::fillFrame(unsigned char* frame, uint64_t step, const int* actions)
+{
+	memcpy(frame, &step, sizeof(step));
+	int* statuses = reinterpret_cast<int*>(frame + m_header->statusesOffset);
+	int* rewards = reinterpret_cast<int*>(frame + m_header->rewardsOffset);
+	unsigned char* dones = frame + m_header->donesOffset;
+	unsigned char* observations = frame + m_header->observationsOffset;
+	if (actions != nullptr)
+	{
+		m_env.step(actions, statuses, rewards, dones, observations);
+		return;
+	}
+
+	  // the first frame only shows where every world starts
+	for (int i = 0; i < m_env.getWorldCount(); i++)
+	{
+		statuses[i] = GWSTATUS_CONTINUE_GAME;
+		rewards[i] = 0;
+		dones[i] = 0;
+	}
+	m_env.observe(observations);
+}
+
+bool SharedMemoryServer::serve(const string& name)
+{
+	if (!m_env.reset())
+		return false;
+	if (!create(name))
+		return false;
+
+	  // the ring is empty, so the first slot is free
+	fillFrame(m_frames.writeSlot(), 0, nullptr);
+	m_frames.publish();
+	m_header->magic.store(MAGIC, memory_order_release);
+
+	for (uint64_t step = 1; ; step++)
+	{
+		const unsigned char* actions = nullptr;
+		unsigned char* frame = nullptr;
+		for (int waits = 0; !isClosed(); waits++)
+		{
+			if (actions == nullptr)
+				actions = m_actions.readSlot();
+			if (actions != nullptr && frame == nullptr)
+				frame = m_frames.writeSlot();
+			if (frame != nullptr)
+				break;
+			  // a trainer that died without closing never will, so its absence is checked once it is slow
+			if (waits >= 1000 && isTrainerGone())
+				break;
+			backOff(waits);
+		}
+		if (frame == nullptr)
+			break;
+
+		fillFrame(frame, step, reinterpret_cast<const int*>(actions));
+		m_actions.release();
+		m_frames.publish();
+	}
+
+	destroy();
+	return true;
+}
@@ -0,0 +1,80 @@
+#ifndef SHAREDMEMORYSERVER_H_
+#define SHAREDMEMORYSERVER_H_
+
+#include "BatchEnvironment.h"
+#include "SharedMemoryRing.h"
+#include <string>
+#include <cstdint>
+
+// Publishes a batch of worlds through a POSIX shared memory segment, so a trainer in another process reads every
+// tick's results where the simulator wrote them and hands back actions the same way (POSIX only). The segment
+// holds a Header followed by two rings (see SharedMemoryRing.h):
+//
+//   frames    simulator to trainer, frameCapacity slots of frameSize bytes, each the results of one step:
+//             a uint64_t step number, then at the offsets in the header worldCount int32_t statuses,
+//             worldCount int32_t rewards, worldCount uint8_t done flags and worldCount observations of
+//             observationSize bytes, laid out as BatchEnvironment::step() writes them
+//   actions   trainer to simulator, actionCapacity slots of worldCount int32_t keys (KEY_PRESS_ values, or 0)
+//
+// Frame 0 holds the first observations. After that the server waits for an action slot, steps every world with
+// it straight into the next free frame slot, releases the action slot and publishes the frame. Worlds whose
+// episodes end are reset as in BatchEnvironment. The trainer waits for magic to appear before reading the rest of
+// the header, writes its process id to trainerPid, and sets closed to stop the server, which then unlinks the
+// segment; a server whose trainer has exited without closing stops too. A server kept waiting spins, then yields,
+// then sleeps a little longer each time, so an idle trainer costs next to nothing. All integers are native endian.
+//
+class SharedMemoryServer
+{
+public:
+	static const uint32_t MAGIC = 0x53505352;	// "SPSR"
+	static const uint32_t VERSION = 2;
+	static const uint32_t FRAME_CAPACITY = 8;
+	static const uint32_t ACTION_CAPACITY = 8;
+
+	struct Header
+	{
+		std::atomic<uint32_t> magic;	// MAGIC once the rest of the segment is ready
+		uint32_t version;
+		uint32_t worldCount;
+		uint32_t observationSize;		// bytes per world
+		uint32_t frameCapacity;
+		uint32_t actionCapacity;
+		uint64_t frameSize;				// bytes per frame slot
+		uint64_t actionSize;			// bytes per action slot
+		uint64_t framesOffset;			// from the start of the segment
+		uint64_t actionsOffset;
+		uint64_t statusesOffset;		// from the start of a frame slot
+		uint64_t rewardsOffset;
+		uint64_t donesOffset;
+		uint64_t observationsOffset;
+		std::atomic<uint32_t> closed;	// set by the trainer to stop the server
+		std::atomic<int32_t> trainerPid;	// set by the trainer once it has attached, 0 until then
+		RingIndices frames;
+		RingIndices actions;
+	};
+
+	SharedMemoryServer(std::string assetPath, int worldCount, int startLevel, uint64_t seed,
+		unsigned int threadCount);
+	~SharedMemoryServer();
+
+	// Creates the segment under name (such as "/sps") and serves until the trainer closes it or exits; false if
+	// the level cannot be loaded or the segment cannot be created, as when another server already owns the name
+	bool serve(const std::string& name);
+
+private:
+	bool create(const std::string& name);
+	void destroy();
+	bool isClosed() const { return m_header->closed.load(std::memory_order_acquire) != 0; }
+	bool isTrainerGone() const;
+	void fillFrame(unsigned char* frame, uint64_t step, const int* actions);
+
+	BatchEnvironment m_env;
+	std::string m_name;
+	unsigned char* m_segment = nullptr;
+	size_t m_segmentSize = 0;
+	Header* m_header = nullptr;
+	SpscRing m_frames;
+	SpscRing m_actions;
+};
+
+#endif // SHAREDMEMORYSERVER_H_
@@ -0,0 +1,127 @@
+#include "SimulationApi.h"
+#include "BatchEnvironment.h"
+#include "StudentWorld.h"
+#include "GameConstants.h"
+#include <new>
+using namespace std;
+
+static_assert(sizeof(int) == sizeof(int32_t), "the C interface passes int arrays as int32_t");
+static_assert(SPS_STATUS_PLAYER_DIED == GWSTATUS_PLAYER_DIED && SPS_STATUS_CONTINUE == GWSTATUS_CONTINUE_GAME &&
+	SPS_STATUS_PLAYER_WON == GWSTATUS_PLAYER_WON && SPS_STATUS_FINISHED_LEVEL == GWSTATUS_FINISHED_LEVEL &&
+	SPS_STATUS_LEVEL_ERROR == GWSTATUS_LEVEL_ERROR, "C statuses must be the game's statuses");
+static_assert(SPS_CHANNEL_TERRAIN == (int)CHANNEL_TERRAIN && SPS_CHANNEL_PEACH == (int)CHANNEL_PEACH &&
+	SPS_CHANNEL_GOOMBA == (int)CHANNEL_GOOMBA && SPS_CHANNEL_KOOPA == (int)CHANNEL_KOOPA && SPS_CHANNEL_PIRANHA == (int)CHANNEL_PIRANHA &&
+	SPS_CHANNEL_PICKUP == (int)CHANNEL_PICKUP && SPS_CHANNEL_PLAYER_PROJECTILE == (int)CHANNEL_PLAYER_PROJECTILE &&
+	SPS_CHANNEL_ENEMY_PROJECTILE == (int)CHANNEL_ENEMY_PROJECTILE && SPS_CHANNEL_TARGET == (int)CHANNEL_TARGET &&
+	SPS_CHANNEL_COUNT == (int)CHANNEL_COUNT, "C channels must be the world's observation channels");
+static_assert(SPS_EGOCENTRIC_WIDTH == ObservationGrid::EGOCENTRIC_WIDTH &&
+	SPS_EGOCENTRIC_HEIGHT == ObservationGrid::EGOCENTRIC_HEIGHT, "C egocentric window must be the world's");
+static_assert(SPS_STOP_ON_SCORE == (int)StudentWorld::STOP_ON_SCORE && SPS_STOP_ON_HIT == (int)StudentWorld::STOP_ON_HIT,
+	"C stop conditions must be the world's");
+
+static const int s_actionKeys[SPS_ACTION_COUNT] =
+{
+	0, KEY_PRESS_LEFT, KEY_PRESS_RIGHT, KEY_PRESS_UP, KEY_PRESS_DOWN, KEY_PRESS_SPACE
+};
+
+// The opaque handle is the environment itself, so each call is one cast away from the C++ object
+struct sps_batch : public BatchEnvironment
+{
+	using BatchEnvironment::BatchEnvironment;
+};
+
+  // no exception may cross into the caller's language, so every call that runs the worlds goes through here,
+  // including those thrown on the pool's threads, which the pool hands back to the calling thread
+template <class Call>
+static int guarded(Call call)
+{
+	try
+	{
+		call();
+		return 1;
+	}
+	catch (...)
+	{
+		return 0;
+	}
+}
+
+int sps_api_version(void)
+{
+	return SPS_API_VERSION;
+}
+
+int sps_observation_size(void)
+{
+	return StudentWorld::OBSERVATION_SIZE;
+}
+
+int sps_egocentric_size(void)
+{
+	return StudentWorld::EGOCENTRIC_OBSERVATION_SIZE;
+}
+
+sps_batch* sps_create(const char* assetDirectory, int worldCount, int startLevel, uint64_t seed, int threadCount)
+{
+	if (assetDirectory == nullptr || worldCount <= 0 || threadCount < 0)
+		return nullptr;
+
+	sps_batch* batch = nullptr;
+	try
+	{
+		batch = new sps_batch(assetDirectory, worldCount, startLevel, seed, (unsigned int)threadCount);
+		batch->setActionKeys(s_actionKeys, SPS_ACTION_COUNT);
+		if (batch->reset())
+			return batch;
+	}
+	catch (...)
+	{
+	}
+	delete batch;
+	return nullptr;
+}
+
+void sps_destroy(sps_batch* batch)
+{
+	delete batch;
+}
+
+int sps_world_count(const sps_batch* batch)
+{
+	return batch->getWorldCount();
+}
+
+int sps_reset(sps_batch* batch, const uint8_t* selected)
+{
+	bool loaded = false;
+	int succeeded = guarded([&] { loaded = batch->reset(selected); });
+	return succeeded && loaded ? 1 : 0;
+}
+
+int sps_step(sps_batch* batch, const int32_t* actions, int32_t* rewards, uint8_t* dones, int32_t* statuses,
+	uint8_t* observations)
+{
+	return guarded([&] {
+		batch->step(reinterpret_cast<const int*>(actions), reinterpret_cast<int*>(statuses),
+			reinterpret_cast<int*>(rewards), dones, observations);
+	});
+}
+
+int sps_step_repeat(sps_batch* batch, const int32_t* actions, int repeat, uint32_t stopOn, int32_t* rewards,
+	uint8_t* dones, int32_t* statuses, int32_t* ticks, uint8_t* observations)
+{
+	return guarded([&] {
+		batch->stepRepeat(reinterpret_cast<const int*>(actions), repeat, stopOn, reinterpret_cast<int*>(statuses),
+			reinterpret_cast<int*>(rewards), dones, reinterpret_cast<int*>(ticks), observations);
+	});
+}
+
+int sps_observe(sps_batch* batch, uint8_t* observations)
+{
+	return guarded([&] { batch->observe(observations); });
+}
+
+int sps_observe_egocentric(sps_batch* batch, uint8_t* observations)
+{
+	return guarded([&] { batch->observeEgocentric(observations); });
+}
@@ -0,0 +1,121 @@
+#ifndef SIMULATIONAPI_H_
+#define SIMULATIONAPI_H_
+
+// Plain C interface to a batch of headless worlds, built as the SuperPeachSistersSim shared library so code in
+// other languages can drive the game. Every call that produces per-world results writes them into arrays the
+// caller allocated once, indexed by world; nothing is allocated or copied per step beyond those writes.
+//
+//   sps_batch* batch = sps_create("Assets/", 64, 1, 42, 0);
+//   sps_step(batch, actions, rewards, dones, statuses, observations);
+//   sps_destroy(batch);
+//
+// Observations are sps_observation_size() bytes per world: for each channel below, a GRID_HEIGHT by GRID_WIDTH
+// grid, row 0 at the bottom, counting the actors of that channel whose lower left corner lies in each cell
+// (255 for any more than that).
+// Egocentric observations are sps_egocentric_size() bytes per world, the same channels cropped to a
+// SPS_EGOCENTRIC_HEIGHT by SPS_EGOCENTRIC_WIDTH window centred on Peach, with cells off the level reading 0.
+//
+// No C++ exception ever reaches the caller. The calls that run the worlds return 1, or 0 if something failed
+// along the way, such as running out of memory; the outputs of a failed call are incomplete, and the worlds it
+// was running should be reset before they are stepped again.
+
+#include <stdint.h>
+
+#if defined(_WIN32)
+#define SPS_API __declspec(dllexport)
+#else
+#define SPS_API __attribute__((visibility("default")))
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define SPS_API_VERSION 4
+
+#define SPS_EGOCENTRIC_WIDTH  15
+#define SPS_EGOCENTRIC_HEIGHT 15
+
+typedef struct sps_batch sps_batch;
+
+// Actions, one per world per step
+enum
+{
+	SPS_ACTION_NONE  = 0,
+	SPS_ACTION_LEFT  = 1,
+	SPS_ACTION_RIGHT = 2,
+	SPS_ACTION_JUMP  = 3,
+	SPS_ACTION_DOWN  = 4,
+	SPS_ACTION_FIRE  = 5,
+	SPS_ACTION_COUNT = 6
+};
+
+// Statuses, as returned by the game's move()
+enum
+{
+	SPS_STATUS_PLAYER_DIED    = 0,
+	SPS_STATUS_CONTINUE       = 1,
+	SPS_STATUS_PLAYER_WON     = 2,
+	SPS_STATUS_FINISHED_LEVEL = 3,
+	SPS_STATUS_LEVEL_ERROR    = 4
+};
+
+// Conditions that end a repeated step early, besides the end of the episode
+enum
+{
+	SPS_STOP_ON_SCORE = 1 << 0,
+	SPS_STOP_ON_HIT   = 1 << 1
+};
+
+// Observation channels
+enum
+{
+	SPS_CHANNEL_TERRAIN           = 0,
+	SPS_CHANNEL_PEACH             = 1,
+	SPS_CHANNEL_GOOMBA            = 2,
+	SPS_CHANNEL_KOOPA             = 3,
+	SPS_CHANNEL_PIRANHA           = 4,
+	SPS_CHANNEL_PICKUP            = 5,
+	SPS_CHANNEL_PLAYER_PROJECTILE = 6,
+	SPS_CHANNEL_ENEMY_PROJECTILE  = 7,
+	SPS_CHANNEL_TARGET            = 8,
+	SPS_CHANNEL_COUNT             = 9
+};
+
+SPS_API int sps_api_version(void);
+SPS_API int sps_observation_size(void);
+SPS_API int sps_egocentric_size(void);
+
+// Creates worldCount worlds playing startLevel from the level files in assetDirectory, stepped on threadCount
+// threads (0 for one per hardware thread), and starts their first episodes. Null if the level cannot be loaded.
+SPS_API sps_batch* sps_create(const char* assetDirectory, int worldCount, int startLevel, uint64_t seed,
+	int threadCount);
+SPS_API void sps_destroy(sps_batch* batch);
+
+SPS_API int sps_world_count(const sps_batch* batch);
+
+// Starts new episodes in the worlds whose byte in selected is nonzero, or in all of them when it is null;
+// returns 0 if a level could not be loaded or the reset failed
+SPS_API int sps_reset(sps_batch* batch, const uint8_t* selected);
+
+// Moves every world one tick with actions[i] and writes each world's score gained, episode-ended flag, status
+// and resulting observation. A world whose episode ended is reset before its observation is taken. Any output
+// may be null to skip it; actions may be null for no key anywhere.
+SPS_API int sps_step(sps_batch* batch, const int32_t* actions, int32_t* rewards, uint8_t* dones,
+	int32_t* statuses, uint8_t* observations);
+
+// Like sps_step, but each world repeats its action for up to repeat ticks in one call, stopping early when its
+// episode ends or a condition in stopOn (SPS_STOP_ON_ flags) is met. Rewards are summed over the ticks run, and
+// ticks receives how many ticks each world ran.
+SPS_API int sps_step_repeat(sps_batch* batch, const int32_t* actions, int repeat, uint32_t stopOn,
+	int32_t* rewards, uint8_t* dones, int32_t* statuses, int32_t* ticks, uint8_t* observations);
+
+// Writes every world's current observation, or its egocentric window
+SPS_API int sps_observe(sps_batch* batch, uint8_t* observations);
+SPS_API int sps_observe_egocentric(sps_batch* batch, uint8_t* observations);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // SIMULATIONAPI_H_
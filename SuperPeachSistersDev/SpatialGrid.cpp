@@ -0,0 +1,132 @@
+#include "SpatialGrid.h"
+#include "Actor.h"
+#include <algorithm>
+#include <cmath>
+using namespace std;
+
+SpatialGrid::CellRange SpatialGrid::cellsFor(double x, double y, double width, double height)
+{
+	// spaces are half open, [x, x + width), so the last cell is the one holding the last pixel
+	CellRange range;
+	range.x0 = max(0, (int)floor(x / CELL_WIDTH));
+	range.y0 = max(0, (int)floor(y / CELL_HEIGHT));
+	range.x1 = min(COLUMNS - 1, (int)ceil((x + width) / CELL_WIDTH) - 1);
+	range.y1 = min(ROWS - 1, (int)ceil((y + height) / CELL_HEIGHT) - 1);
+	// spaces wholly off one side of the grid still share the edge cells with anything they might touch
+	range.x0 = min(range.x0, COLUMNS - 1);
+	range.y0 = min(range.y0, ROWS - 1);
+	range.x1 = max(range.x1, 0);
+	range.y1 = max(range.y1, 0);
+	return range;
+}
+
+void SpatialGrid::insertInto(Actor* actor, const CellRange& range)
+{
+	unsigned categories = actor->getCategory();
+	for (int cy = range.y0; cy <= range.y1; cy++)
+	{
+		m_rows[cy].push_back(Entry{ actor, (short)range.x0, (short)range.x1, categories });
+		m_rowCategories[cy] |= categories;
+	}
+}
+
+void SpatialGrid::removeFrom(Actor* actor, const CellRange& range)
+{
+	for (int cy = range.y0; cy <= range.y1; cy++)
+	{
+		vector<Entry>& row = m_rows[cy];
+		// rows hold a handful of actors, so the summary is cheaper to rebuild than to count
+		unsigned categories = 0;
+		for (size_t i = 0; i < row.size(); )
+		{
+			if (row[i].actor == actor)
+			{
+				row[i] = row.back();
+				row.pop_back();
+				continue;
+			}
+			categories |= row[i].categories;
+			i++;
+		}
+		m_rowCategories[cy] = categories;
+	}
+}
+
+void SpatialGrid::insert(Actor* actor)
+{
+	insertInto(actor, cellsFor(actor->getX(), actor->getY(), SPRITE_WIDTH, SPRITE_HEIGHT));
+}
+
+void SpatialGrid::remove(Actor* actor)
+{
+	removeFrom(actor, cellsFor(actor->getX(), actor->getY(), SPRITE_WIDTH, SPRITE_HEIGHT));
+}
+
+void SpatialGrid::move(Actor* actor, double oldX, double oldY)
+{
+	CellRange oldRange = cellsFor(oldX, oldY, SPRITE_WIDTH, SPRITE_HEIGHT);
+	CellRange newRange = cellsFor(actor->getX(), actor->getY(), SPRITE_WIDTH, SPRITE_HEIGHT);
+	if (oldRange == newRange)
+	{
+		return;
+	}
+	if (oldRange.y0 != newRange.y0 || oldRange.y1 != newRange.y1)
+	{
+		removeFrom(actor, oldRange);
+		insertInto(actor, newRange);
+		return;
+	}
+	// moving along its rows only changes the columns it spans
+	for (int cy = newRange.y0; cy <= newRange.y1; cy++)
+	{
+		for (Entry& entry : m_rows[cy])
+		{
+			if (entry.actor == actor)
+			{
+				entry.x0 = (short)newRange.x0;
+				entry.x1 = (short)newRange.x1;
+				break;
+			}
+		}
+	}
+}
+
+void SpatialGrid::clear()
+{
+	for (int cy = 0; cy < ROWS; cy++)
+	{
+		m_rows[cy].clear();
+		m_rowCategories[cy] = 0;
+	}
+}
+
+void SpatialGrid::query(double x, double y, double width, double height, unsigned categories, vector<Actor*>& result) const
+{
+	result.clear();
+	if (categories == 0)
+	{
+		return;
+	}
+	CellRange range = cellsFor(x, y, width, height);
+	for (int cy = range.y0; cy <= range.y1; cy++)
+	{
+		if ((m_rowCategories[cy] & categories) == 0)
+		{
+			continue;
+		}
+		const vector<Entry>& row = m_rows[cy];
+		for (auto entryIterator = row.begin(); entryIterator != row.end(); ++entryIterator)
+		{
+			if ((entryIterator->categories & categories) && entryIterator->x0 <= range.x1 && entryIterator->x1 >= range.x0)
+			{
+				result.push_back(entryIterator->actor);
+			}
+		}
+	}
+	if (result.size() < 2)
+	{
+		return;
+	}
+	sort(result.begin(), result.end(), [](Actor* a, Actor* b) { return a->getSequence() < b->getSequence(); });
+	result.erase(unique(result.begin(), result.end()), result.end());
+}
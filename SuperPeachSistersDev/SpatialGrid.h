@@ -0,0 +1,60 @@
+#ifndef SPATIALGRID_H_
+#define SPATIALGRID_H_
+
+#include "GameConstants.h"
+#include <vector>
+#include <cstddef>
+
+class Actor;
+
+// Uniform grid of sprite sized cells over the level, so collision queries only have to look at the actors near the
+// space being tested. Only moving actors are bucketed (terrain is in the TerrainMap), and there are few of them, so
+// the grid keeps one list per row of the actors touching it, each with the columns it spans, rather than a list per
+// cell: a row is scanned whole, and the grid costs a few hundred bytes rather than a vector for every cell.
+//
+class SpatialGrid
+{
+public:
+	void insert(Actor* actor);
+	void remove(Actor* actor);
+	void move(Actor* actor, double oldX, double oldY);
+	void clear();
+	// Makes room in a row for the given number of actors, so a level's first ticks do not grow it one at a time
+	void reserve(int row, std::size_t count) { m_rows[row].reserve(count); }
+
+	// Collects every actor in one of the given categories bucketed in the cells touched by the space, once each and
+	// in the order they were added to the world, so callers see candidates in the same order as a scan over the
+	// whole actor list; cells holding none of the categories are skipped without looking at their actors
+	void query(double x, double y, double width, double height, unsigned categories, std::vector<Actor*>& result) const;
+
+private:
+	static const int CELL_WIDTH = SPRITE_WIDTH;
+	static const int CELL_HEIGHT = SPRITE_HEIGHT;
+	static const int COLUMNS = GRID_WIDTH;
+	static const int ROWS = GRID_HEIGHT;
+
+	struct CellRange
+	{
+		int x0, y0, x1, y1;
+		bool operator==(const CellRange& other) const
+		{
+			return x0 == other.x0 && y0 == other.y0 && x1 == other.x1 && y1 == other.y1;
+		}
+	};
+	static CellRange cellsFor(double x, double y, double width, double height);
+
+	void insertInto(Actor* actor, const CellRange& range);
+	void removeFrom(Actor* actor, const CellRange& range);
+
+	struct Entry
+	{
+		Actor* actor;
+		short x0;
+		short x1;
+		unsigned categories;
+	};
+	std::vector<Entry> m_rows[ROWS];
+	unsigned m_rowCategories[ROWS] = {};
+};
+
+#endif // SPATIALGRID_H_
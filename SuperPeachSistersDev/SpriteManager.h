@@ -12,6 +12,7 @@
 #endif
 
 #include "GameConstants.h"
+#include <cmath>
 #include <cstring>
 #include <iostream>
 #include <fstream>
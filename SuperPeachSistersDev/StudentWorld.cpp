@@ -1,10 +1,14 @@
 #include "StudentWorld.h"
+#include "ActorDispatch.h"
 #include "GameConstants.h"
 #include <string>
 #include <iostream>
 #include <iomanip>
-#include <list>
 #include <sstream>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <climits>
 using namespace std;
 
 GameWorld* createStudentWorld(string assetPath)
@@ -12,154 +16,974 @@ GameWorld* createStudentWorld(string assetPath)
 	return new StudentWorld(assetPath);
 }
 
+static const InteractionTable s_bonkTable = makeInteractionTable<BonkInteraction>(AllActorTypes());
+static const InteractionTable s_damageTable = makeInteractionTable<DamageInteraction>(AllActorTypes());
+static const InteractionMasks s_bonkMasks = makeBonkMasks(AllActorTypes());
+static const InteractionMasks s_damageMasks = makeDamageMasks(AllActorTypes());
+
+static const InteractionMasks s_triggerVolumes = makeTriggerVolumes(AllActorTypes());
+static const SightHeights s_sightHeights = makeSightHeights(AllActorTypes());
+static const ObservationChannels s_observationChannels = makeObservationChannels(AllActorTypes());
+static const KindFlags s_statelessTerrain = makeStatelessTerrain(AllActorTypes());
+static const InteractionMasks s_categories = makeCategories(AllActorTypes());
+static const SaveStateFunctions s_saveState = makeSaveStateFunctions(AllActorTypes());
+static const LoadStateFunctions s_loadState = makeLoadStateFunctions(AllActorTypes());
+
 // Students:  Add code to this file, StudentWorld.h, Actor.h, and Actor.cpp
 
+void StudentWorld::actorChanged(Actor* actor)
+{
+    if (m_stateHashing && !actor->m_stateChanged)
+    {
+        actor->m_stateChanged = true;
+        m_changedActors.push_back(actor);
+    }
+}
+
 int StudentWorld::init()
 {
-    // load the current level
-    int levelNumber = this->getLevel();
-    string fileName = getLevelFileName(levelNumber);
-    Level* level = new Level(assetPath());
-    int result = level->loadLevel(fileName);
-    if (result != Level::load_success) 
-    {
-        // as long as the first level can be loaded the game is won when the next level file is not found
-        if (result == Level::load_fail_file_not_found) cerr << "ERROR: Could not find level " << levelNumber << " file '" << fileName << "'.";
-        if (result == Level::load_fail_bad_format) cerr << "ERROR: Bad format error in level " << levelNumber << " file '" << fileName << "'.";
+    if (!loadLevel())
+    {
         return GWSTATUS_LEVEL_ERROR;
     }
 
-    // load the actors in the level
-    m_player = 0;
-    for (int gy = 0; gy < GRID_HEIGHT; gy++)
+    // each start of a level gets its own stream, the same for the same seed
+    m_random.setSeed(m_seed ^ WorldRandom::mix(++m_levelStarts));
+
+    // load the actors in the level; the terrain is already in the template's bitboard and observation
+    const vector<LevelTemplate::Entry>& entries = m_levelTemplate->getEntries();
+    reserveGridRows(entries);
+    for (size_t i = 0; i < entries.size(); i++)
     {
-        for (int gx = 0; gx < GRID_WIDTH; gx++)
-        {
-            Level::GridEntry entry = level->getContentsOf(gx, gy);
-            if (entry == Level::GridEntry::empty) continue;
-            switch (entry)
-            {
-            case Level::GridEntry::empty:
-                break;
-            case Level::GridEntry::block:
-                addActor(new BlockActor(this, gx * SPRITE_WIDTH, gy * SPRITE_HEIGHT));
-                break;
-            case Level::GridEntry::star_goodie_block:
-                addActor(new StarGoodieBlockActor(this, gx * SPRITE_WIDTH, gy * SPRITE_HEIGHT));
-                break;
-            case Level::GridEntry::flower_goodie_block:
-                addActor(new FlowerGoodieBlockActor(this, gx * SPRITE_WIDTH, gy * SPRITE_HEIGHT));
-                break;
-            case Level::GridEntry::mushroom_goodie_block:
-                addActor(new MushroomGoodieBlockActor(this, gx * SPRITE_WIDTH, gy * SPRITE_HEIGHT));
-                break;
-            case Level::GridEntry::pipe:
-                addActor(new PipeActor(this, gx * SPRITE_WIDTH, gy * SPRITE_HEIGHT));
-                break;
-            case Level::GridEntry::koopa:
-                addActor(new KoopaEnemyActor(this, gx * SPRITE_WIDTH, gy * SPRITE_HEIGHT));
-                break;
-            case Level::GridEntry::goomba:
-                addActor(new GoombaEnemyActor(this, gx * SPRITE_WIDTH, gy * SPRITE_HEIGHT));
-                break;
-            case Level::GridEntry::piranha:
-                addActor(new PiranhaEnemyActor(this, gx * SPRITE_WIDTH, gy * SPRITE_HEIGHT));
-                break;
-            case Level::GridEntry::peach:
-                m_player = new PeachActor(this, gx * SPRITE_WIDTH, gy * SPRITE_HEIGHT);
-                addActor(m_player);
-                break;
-            case Level::GridEntry::flag:
-                addActor(new FlagPlayerTargetActor(this, gx * SPRITE_WIDTH, gy * SPRITE_HEIGHT));
-                break;
-            case Level::GridEntry::mario:
-                addActor(new MarioPlayerTargetActor(this, gx * SPRITE_WIDTH, gy * SPRITE_HEIGHT));
-                break;
-            }
-        }
+        if (m_terrainShared && s_statelessTerrain[entries[i].kind]) continue;
+        // skipped entries keep their sequences, so the actors built get the same ones either way
+        m_nextSequence = (unsigned int)i;
+        addLevelActor(entries[i]);
     }
+    m_nextSequence = (unsigned int)entries.size();
     startLevel();
     updateGameStats();
+    if (m_stateHashing)
+    {
+        rehashAllActors();
+    }
+
+    // a replay starting part way through jumps there from the first level started
+    if (m_replayPlayer != nullptr && !m_replayPlayer->levelStarted(*this))
+    {
+        return GWSTATUS_LEVEL_ERROR;
+    }
     return GWSTATUS_CONTINUE_GAME;
 }
 
-int StudentWorld::move()
+bool StudentWorld::loadLevel(shared_ptr<const LevelTemplate> levelTemplate)
 {
+    // load the current level, parsed once for every world that plays it, unless the template is already at hand
+    int levelNumber = this->getLevel();
+    if (levelTemplate == nullptr && m_lastTemplate != nullptr && m_lastTemplateLevel == levelNumber)
+    {
+        levelTemplate = m_lastTemplate;
+    }
+    if (levelTemplate == nullptr)
+    {
+        string fileName = getLevelFileName(levelNumber);
+        Level::LoadResult result = Level::load_success;
+        levelTemplate = LevelTemplate::get(assetPath(), fileName, result);
+        if (levelTemplate == nullptr)
+        {
+            // as long as the first level can be loaded the game is won when the next level file is not found
+            if (result == Level::load_fail_file_not_found) cerr << "ERROR: Could not find level " << levelNumber << " file '" << fileName << "'.";
+            if (result == Level::load_fail_bad_format) cerr << "ERROR: Bad format error in level " << levelNumber << " file '" << fileName << "'.";
+            return false;
+        }
+    }
+    m_levelTemplate = levelTemplate;
+    m_lastTemplate = levelTemplate;
+    m_lastTemplateLevel = levelNumber;
+
+    m_player = ActorHandle();
+    m_terrain.setLevel(m_levelTemplate.get());
+    m_observation = m_levelTemplate->getTerrainObservation();
+    return true;
+}
+
+void StudentWorld::reserveGridRows(const vector<LevelTemplate::Entry>& entries)
+{
+    // an actor starts in one row and straddles the next as it walks or falls, so each row makes room for the actors
+    // starting in it and beside it; rows keep their room through cleanUp(), so only a level's first start grows them
+    size_t starting[GRID_HEIGHT] = {};
+    for (size_t i = 0; i < entries.size(); i++)
+    {
+        if (s_categories[entries[i].kind] != CATEGORY_TERRAIN)
+        {
+            starting[entries[i].gy]++;
+        }
+    }
+    for (int row = 0; row < GRID_HEIGHT; row++)
+    {
+        size_t count = starting[row] + (row > 0 ? starting[row - 1] : 0) + (row + 1 < GRID_HEIGHT ? starting[row + 1] : 0);
+        if (count > 0)
+        {
+            m_grid.reserve(row, count);
+        }
+    }
+}
+
+void StudentWorld::addLevelActor(const LevelTemplate::Entry& entry)
+{
+    int gx = entry.gx;
+    int gy = entry.gy;
+    int x = gx * SPRITE_WIDTH;
+    int y = gy * SPRITE_HEIGHT;
+    switch (entry.kind)
+    {
+    case KIND_BLOCK:
+        addTerrain(createTerrainActor<BlockActor>(x, y), gx, gy);
+        break;
+    case KIND_STAR_BLOCK:
+        addTerrain(createTerrainActor<StarGoodieBlockActor>(x, y), gx, gy);
+        break;
+    case KIND_FLOWER_BLOCK:
+        addTerrain(createTerrainActor<FlowerGoodieBlockActor>(x, y), gx, gy);
+        break;
+    case KIND_MUSHROOM_BLOCK:
+        addTerrain(createTerrainActor<MushroomGoodieBlockActor>(x, y), gx, gy);
+        break;
+    case KIND_PIPE:
+        addTerrain(createTerrainActor<PipeActor>(x, y), gx, gy);
+        break;
+    case KIND_KOOPA:
+        addActor(createActor<KoopaEnemyActor>(x, y));
+        break;
+    case KIND_GOOMBA:
+        addActor(createActor<GoombaEnemyActor>(x, y));
+        break;
+    case KIND_PIRANHA:
+        addActor(createActor<PiranhaEnemyActor>(x, y));
+        break;
+    case KIND_PEACH:
+        m_player = addActor(createActor<PeachActor>(x, y));
+        break;
+    case KIND_FLAG:
+        addActor(createActor<FlagPlayerTargetActor>(x, y));
+        break;
+    case KIND_MARIO:
+        addActor(createActor<MarioPlayerTargetActor>(x, y));
+        break;
+    default:
+        break;
+    }
+}
+
+Actor* StudentWorld::createActorOfKind(ActorKind kind, int x, int y, int direction)
+{
+    switch (kind)
+    {
+    case KIND_PEACH:        return createActor<PeachActor>(x, y);
+    case KIND_GOOMBA:       return createActor<GoombaEnemyActor>(x, y);
+    case KIND_KOOPA:        return createActor<KoopaEnemyActor>(x, y);
+    case KIND_PIRANHA:      return createActor<PiranhaEnemyActor>(x, y);
+    case KIND_PEACH_FIRE:   return createActor<PeachFireballActor>(x, y, direction);
+    case KIND_PIRANHA_FIRE: return createActor<PiranhaFireballActor>(x, y, direction);
+    case KIND_SHELL:        return createActor<ShellActor>(x, y, direction);
+    case KIND_STAR:         return createActor<StarGoodieActor>(x, y);
+    case KIND_FLOWER:       return createActor<FlowerGoodieActor>(x, y);
+    case KIND_MUSHROOM:     return createActor<MushroomGoodieActor>(x, y);
+    case KIND_FLAG:         return createActor<FlagPlayerTargetActor>(x, y);
+    case KIND_MARIO:        return createActor<MarioPlayerTargetActor>(x, y);
+    default:                return nullptr;
+    }
+}
+
+bool StudentWorld::saveSnapshot(vector<unsigned char>& bytes) const
+{
+    bytes.clear();
+    // a tick that ended the life or level leaves nothing to play on from
+    if (m_levelTemplate == nullptr || getPlayer() == nullptr || isTickOver())
+    {
+        return false;
+    }
+    SnapshotWriter writer(bytes);
+    writer.putU32(SNAPSHOT_MAGIC);
+    writer.putU16(SNAPSHOT_VERSION);
+    writeProgress(writer);
+
+    // terrain with state is always built, so each such template entry has its actor
+    const vector<LevelTemplate::Entry>& entries = m_levelTemplate->getEntries();
+    vector<size_t> statefulTerrain;
+    for (size_t i = 0; i < entries.size(); i++)
+    {
+        if (s_categories[entries[i].kind] == CATEGORY_TERRAIN && !s_statelessTerrain[entries[i].kind])
+        {
+            statefulTerrain.push_back(i);
+        }
+    }
+    writer.putU16((unsigned)statefulTerrain.size());
+    for (auto entryIterator = statefulTerrain.begin(); entryIterator != statefulTerrain.end(); ++entryIterator)
+    {
+        s_saveState[entries[*entryIterator].kind](m_terrain.getActor((int)*entryIterator), writer);
+    }
+
+    // the rest in actor order, so restoring adds them back in the order they were made
+    vector<Actor*> actors;
     for (auto actorIterator = m_actors.begin(); actorIterator != m_actors.end(); ++actorIterator)
     {
         Actor* actor = *actorIterator;
-        
-        if (actor->isAlive())
+        if (actor != nullptr && actor->isAlive() && actor->getCategory() != CATEGORY_TERRAIN)
+        {
+            actors.push_back(actor);
+        }
+    }
+    sort(actors.begin(), actors.end(), [](Actor* a, Actor* b) { return a->getSequence() < b->getSequence(); });
+    writer.putU16((unsigned)actors.size());
+    for (auto actorIterator = actors.begin(); actorIterator != actors.end(); ++actorIterator)
+    {
+        writeActorRecord(*actorIterator, writer);
+    }
+    return true;
+}
+
+void StudentWorld::writeProgress(SnapshotWriter& writer) const
+{
+    writer.putU16(getLevel());
+    writer.putI16(getLives());
+    writer.putI32(getScore());
+    writer.putU64(m_seed);
+    writer.putU32(m_levelStarts);
+    writer.putU32(m_nextSequence);
+}
+
+void StudentWorld::writeActorRecord(const Actor* actor, SnapshotWriter& writer) const
+{
+    writer.putU8(actor->getKind());
+    writer.putU32(actor->getSequence());
+    writer.putI16((int)actor->getX());
+    writer.putI16((int)actor->getY());
+    writer.putU8((actor->getDirection() == DIRECTION_LEFT ? SNAPSHOT_FACING_LEFT : 0)
+        | (actor->m_playerInside << SNAPSHOT_INSIDE_SHIFT));
+    writer.putI16(actor->m_remainingJumpDistance);
+    writer.putU32(actor->m_randomDraws);
+    s_saveState[actor->getKind()](actor, writer);
+}
+
+void StudentWorld::setStateHashing(bool hashing)
+{
+    m_stateHashing = hashing;
+    if (hashing)
+    {
+        rehashAllActors();
+    }
+    else
+    {
+        for (auto actorIterator = m_changedActors.begin(); actorIterator != m_changedActors.end(); ++actorIterator)
+            (*actorIterator)->m_stateChanged = false;
+        m_changedActors.clear();
+    }
+}
+
+uint64_t StudentWorld::getStateHash()
+{
+    if (!m_stateHashing)
+    {
+        setStateHashing(true);
+    }
+    rehashChangedActors();
+    SnapshotWriter progress;
+    writeProgress(progress);
+    return m_actorsHash ^ WorldRandom::mix(progress.getHash());
+}
+
+uint64_t StudentWorld::hashActor(const Actor* actor) const
+{
+    // dead actors and stateless terrain are not in snapshots, so they have no share
+    if (!actor->isAlive() || s_statelessTerrain[actor->getKind()])
+    {
+        return 0;
+    }
+    SnapshotWriter writer;
+    writeActorRecord(actor, writer);
+    return WorldRandom::mix(writer.getHash());
+}
+
+void StudentWorld::rehashActor(Actor* actor)
+{
+    m_actorsHash ^= actor->m_stateHash;
+    actor->m_stateHash = hashActor(actor);
+    m_actorsHash ^= actor->m_stateHash;
+}
+
+void StudentWorld::rehashChangedActors()
+{
+    for (auto actorIterator = m_changedActors.begin(); actorIterator != m_changedActors.end(); ++actorIterator)
+    {
+        (*actorIterator)->m_stateChanged = false;
+        rehashActor(*actorIterator);
+    }
+    m_changedActors.clear();
+}
+
+void StudentWorld::rehashAllActors()
+{
+    for (auto actorIterator = m_changedActors.begin(); actorIterator != m_changedActors.end(); ++actorIterator)
+        (*actorIterator)->m_stateChanged = false;
+    m_changedActors.clear();
+    m_actorsHash = 0;
+    for (auto actorIterator = m_actors.begin(); actorIterator != m_actors.end(); ++actorIterator)
+    {
+        if (*actorIterator != nullptr)
         {
-            actor->doSomething();
+            (*actorIterator)->m_stateHash = 0;
+            rehashActor(*actorIterator);
         }
+    }
+}
 
-        if (m_playerDied) 
+bool StudentWorld::restoreSnapshot(const unsigned char* bytes, size_t size)
+{
+    SnapshotReader reader(bytes, size);
+    return restoreSnapshot(reader, nullptr);
+}
+
+bool StudentWorld::restoreSnapshot(SnapshotReader& reader, shared_ptr<const LevelTemplate> levelTemplate)
+{
+    if (reader.getU32() != SNAPSHOT_MAGIC || reader.getU16() != SNAPSHOT_VERSION)
+    {
+        return false;
+    }
+    int level = reader.getU16();
+    int lives = reader.getI16();
+    int score = reader.getI32();
+    uint64_t seed = reader.getU64();
+    unsigned int levelStarts = reader.getU32();
+    unsigned int nextSequence = reader.getU32();
+    if (reader.failed())
+    {
+        return false;
+    }
+
+    cleanUp();
+    restoreProgress(level, lives, score);
+    if (!loadLevel(levelTemplate))
+    {
+        return false;
+    }
+    m_seed = seed;
+    m_levelStarts = levelStarts;
+    m_random.setSeed(m_seed ^ WorldRandom::mix(m_levelStarts));
+
+    // terrain comes from the template as init() builds it, then takes the saved state of the entries that have some
+    const vector<LevelTemplate::Entry>& entries = m_levelTemplate->getEntries();
+    unsigned int statefulTerrain = reader.getU16();
+    for (size_t i = 0; i < entries.size(); i++)
+    {
+        ActorKind kind = entries[i].kind;
+        if (s_categories[kind] != CATEGORY_TERRAIN || (m_terrainShared && s_statelessTerrain[kind])) continue;
+        m_nextSequence = (unsigned int)i;
+        addLevelActor(entries[i]);
+        if (!s_statelessTerrain[kind])
+        {
+            s_loadState[kind](m_terrain.getActor((int)i), reader);
+            statefulTerrain--;
+        }
+    }
+
+    // every other actor is made again under its old sequence, then given back its state
+    unsigned int actorCount = statefulTerrain == 0 ? reader.getU16() : 0;
+    for (unsigned int i = 0; i < actorCount && !reader.failed(); i++)
+    {
+        unsigned int kind = reader.getU8();
+        unsigned int sequence = reader.getU32();
+        int x = reader.getI16();
+        int y = reader.getI16();
+        unsigned int flags = reader.getU8();
+        int direction = (flags & SNAPSHOT_FACING_LEFT) ? DIRECTION_LEFT : DIRECTION_RIGHT;
+        if (reader.failed() || kind >= KIND_COUNT || s_categories[kind] == CATEGORY_TERRAIN || sequence == 0)
         {
-            decLives();
-            playSound(SOUND_PLAYER_DIE);
-            return GWSTATUS_PLAYER_DIED;
+            cleanUp();
+            return false;
         }
-        
-        if (m_levelCompleted) 
+        m_nextSequence = sequence - 1;
+        Actor* actor = createActorOfKind((ActorKind)kind, x, y, direction);
+        actor->Actor::setDirection(direction);
+        actor->m_remainingJumpDistance = reader.getI16();
+        actor->m_randomDraws = reader.getU32();
+        actor->m_playerInside = flags >> SNAPSHOT_INSIDE_SHIFT;
+        s_loadState[kind](actor, reader);
+        ActorHandle handle = addActor(actor);
+        if (kind == KIND_PEACH)
         {
-            playSound(SOUND_FINISHED_LEVEL);
-            return GWSTATUS_FINISHED_LEVEL;
+            m_player = handle;
         }
-        
-        if(m_playerWon)
+        if (actor->m_playerInside != TRIGGER_NONE)
         {
-            playSound(SOUND_GAME_OVER);
-            return GWSTATUS_PLAYER_WON;
+            m_sensorsInside.push_back(handle);
         }
     }
+    m_nextSequence = nextSequence;
+
+    if (statefulTerrain != 0 || reader.failed() || !reader.atEnd() || getPlayer() == nullptr)
+    {
+        cleanUp();
+        return false;
+    }
+    startLevel();
+    updateGameStats();
+    if (m_stateHashing)
+    {
+        rehashAllActors();
+    }
+    return true;
+}
+
+unique_ptr<StudentWorld> StudentWorld::fork() const
+{
+    unique_ptr<StudentWorld> child(new StudentWorld(assetPath()));
+    if (!forkInto(*child))
+    {
+        return nullptr;
+    }
+    return child;
+}
+
+bool StudentWorld::forkInto(StudentWorld& child) const
+{
+    // a snapshot carries every actor that can change; the child rebuilds from it on the parent's own template
+    vector<unsigned char> bytes;
+    bytes.reserve(1024);
+    if (!saveSnapshot(bytes))
+    {
+        return false;
+    }
+    // a fork has no host, so it never reads the parent's keys or reaches its sound and status line; run() keys drive it
+    child.setController(nullptr);
+    child.m_terrainShared = m_terrainShared;
+    child.m_stateHashing = m_stateHashing;
+    SnapshotReader reader(bytes.data(), bytes.size());
+    return child.restoreSnapshot(reader, m_levelTemplate);
+}
+
+StudentWorld::RunResult StudentWorld::run(const int* keys, int keyCount, int maxTicks, unsigned stopOn)
+{
+    // a world never initialised, or cleaned up by a failed restore, has nothing to move
+    if (getPlayer() == nullptr)
+    {
+        return RunResult{ GWSTATUS_LEVEL_ERROR, 0, 0, 0 };
+    }
+
+    static const int NO_KEY = 0;
+    if (keys == nullptr || keyCount <= 0)
+    {
+        keys = &NO_KEY;
+        keyCount = 1;
+    }
+    m_runKeys = keys;
+    m_runKeyCount = keyCount;
+
+    RunResult result = { GWSTATUS_CONTINUE_GAME, 0, 0, 0 };
+    int startScore = getScore();
+    for (m_runTick = 0; m_runTick < maxTicks; )
+    {
+        int score = getScore();
+        int hitPoints = getPlayer()->getHitPoints();
+        result.status = move();
+        m_runTick++;
+
+        if (result.status != GWSTATUS_CONTINUE_GAME)
+            break;
+        if ((stopOn & STOP_ON_SCORE) && getScore() != score)
+            result.stoppedBy |= STOP_ON_SCORE;
+        if ((stopOn & STOP_ON_HIT) && getPlayer()->getHitPoints() < hitPoints)
+            result.stoppedBy |= STOP_ON_HIT;
+        if (result.stoppedBy != 0)
+            break;
+    }
+    result.ticks = m_runTick;
+    result.reward = getScore() - startScore;
+
+    m_runKeys = nullptr;
+    m_runKeyCount = 0;
+    return result;
+}
+
+bool StudentWorld::getKey(int& value)
+{
+    bool gotKey;
+    if (m_runKeys != nullptr)
+    {
+        value = m_runKeys[m_runTick % m_runKeyCount];
+        gotKey = value != 0;
+    }
+    else if (m_replayPlayer != nullptr && m_replayPlayer->isTickRecorded())
+    {
+        int hostKey;
+        GameWorld::getKey(hostKey);
+        value = m_replayPlayer->getKey();
+        gotKey = value != 0;
+    }
+    else
+    {
+        gotKey = GameWorld::getKey(value);
+    }
+
+    if (m_replayRecorder != nullptr)
+    {
+        m_replayRecorder->keyRead(gotKey ? value : 0);
+    }
+    return gotKey;
+}
+
+int StudentWorld::move()
+{
+    if (m_replayRecorder != nullptr)
+    {
+        m_replayRecorder->beginTick(*this);
+    }
+    if (m_replayPlayer != nullptr)
+    {
+        m_replayPlayer->beginTick(*this);
+    }
+
+    // every actor that changes another changes the player, so it is marked up front
+    actorChanged(getPlayer());
 
+    // only the active set is ticked, in actor order, and nothing is added or removed until the pass is over; the
+    // per-kind lists are each in actor order, so a heap of one cursor per list merges them by sequence
+    m_tickCursors.clear();
+    for (int kind = 0; kind < KIND_COUNT; kind++)
+    {
+        if (!m_activeActors[kind].empty())
+        {
+            m_tickCursors.push_back(TickCursor{ m_activeActors[kind][0]->getSequence(), kind, 0 });
+        }
+    }
+    auto later = [](const TickCursor& a, const TickCursor& b) { return a.sequence > b.sequence; };
+    make_heap(m_tickCursors.begin(), m_tickCursors.end(), later);
+
+    // sensors before the player in actor order see it where it starts the tick, the rest where its move leaves it
+    unsigned int playerSequence = getPlayer()->getSequence();
+    bool playerMoved = false;
+    m_tickHits.clear();
+    findTriggers(true);
+    size_t nextHit = 0;
+    while (!m_tickCursors.empty() && !isTickOver())
+    {
+        pop_heap(m_tickCursors.begin(), m_tickCursors.end(), later);
+        TickCursor& cursor = m_tickCursors.back();
+        if (!playerMoved && cursor.sequence > playerSequence)
+        {
+            findTriggers(false);
+            playerMoved = true;
+        }
+        triggerActorsUpTo(cursor.sequence, nextHit);
+        if (isTickOver())
+        {
+            break;
+        }
+        (this->*s_tickFunctions[cursor.kind])(m_activeActors[cursor.kind][cursor.index]);
+
+        const vector<Actor*>& actors = m_activeActors[cursor.kind];
+        if (++cursor.index < actors.size())
+        {
+            cursor.sequence = actors[cursor.index]->getSequence();
+            push_heap(m_tickCursors.begin(), m_tickCursors.end(), later);
+        }
+        else
+        {
+            m_tickCursors.pop_back();
+        }
+    }
+    if (!isTickOver())
+    {
+        if (!playerMoved)
+        {
+            findTriggers(false);
+        }
+        // inert sensors may come after the last active actor
+        triggerActorsUpTo(UINT_MAX, nextHit);
+    }
+
+    if (m_playerDied) 
+    {
+        decLives();
+        playSound(SOUND_PLAYER_DIE);
+        return GWSTATUS_PLAYER_DIED;
+    }
+    
+    if (m_levelCompleted) 
+    {
+        playSound(SOUND_FINISHED_LEVEL);
+        return GWSTATUS_FINISHED_LEVEL;
+    }
+    
+    if(m_playerWon)
+    {
+        playSound(SOUND_GAME_OVER);
+        return GWSTATUS_PLAYER_WON;
+    }
+
+    // the hash catches up before the dead are destroyed, so it never holds an actor that is gone
+    if (m_stateHashing)
+    {
+        rehashChangedActors();
+    }
     removeDeadActors();
+    addSpawnedActors();
 
     updateGameStats();
 
     return GWSTATUS_CONTINUE_GAME;
 }
 
+template <class ActorType>
+void StudentWorld::triggerActor(const TriggerHit& hit)
+{
+    ActorType* sensor = static_cast<ActorType*>(hit.actor);
+    if (sensor->isAlive())
+    {
+        if (hit.entered)
+        {
+            sensor->ActorType::playerEntered(getPlayer(), hit.entered);
+        }
+        sensor->ActorType::playerInside(getPlayer(), hit.volumes);
+        actorChanged(sensor);
+    }
+}
+
+template <class ActorType>
+void StudentWorld::tickActor(Actor* actor)
+{
+    if (actor->m_active && actor->isAlive())
+    {
+        static_cast<ActorType*>(actor)->ActorType::doSomething();
+        actorChanged(actor);
+    }
+}
+
+void StudentWorld::triggerActorsUpTo(unsigned int sequence, size_t& nextHit)
+{
+    // each sensor is called back just before its own turn, so the tick plays out exactly as if every sensor had
+    // tested the player itself
+    for (; nextHit < m_tickHits.size() && m_tickHits[nextHit].actor->getSequence() <= sequence && !isTickOver(); nextHit++)
+    {
+        const TriggerHit& hit = m_tickHits[nextHit];
+        (this->*s_triggerFunctions[hit.actor->getKind()])(hit);
+    }
+}
+
+template <class... Types>
+vector<StudentWorld::TickFunction> StudentWorld::makeTickFunctions(ActorTypeList<Types...>)
+{
+    return vector<TickFunction>{ &StudentWorld::tickActor<Types>... };
+}
+
+template <class... Types>
+vector<StudentWorld::TriggerFunction> StudentWorld::makeTriggerFunctions(ActorTypeList<Types...>)
+{
+    return vector<TriggerFunction>{ &StudentWorld::triggerActor<Types>... };
+}
+
+const vector<StudentWorld::TickFunction> StudentWorld::s_tickFunctions = StudentWorld::makeTickFunctions(AllActorTypes());
+const vector<StudentWorld::TriggerFunction> StudentWorld::s_triggerFunctions = StudentWorld::makeTriggerFunctions(AllActorTypes());
+
+bool StudentWorld::bonk(Actor* bonker, Actor* bonked)
+{
+    actorChanged(bonked);
+    return s_bonkTable[bonker->getKind()][bonked->getKind()](bonker, bonked);
+}
+
+bool StudentWorld::damage(Actor* damager, Actor* damaged)
+{
+    actorChanged(damaged);
+    return s_damageTable[damager->getKind()][damaged->getKind()](damager, damaged);
+}
+
 void StudentWorld::startLevel() 
 {
     m_levelCompleted = false;
     m_playerDied = false;
     m_playerWon = false;
+    m_statsKey = -1;
 }
 
 void StudentWorld::cleanUp()
 {
     for (auto actorIterator = m_actors.begin(); actorIterator != m_actors.end(); ++actorIterator)
-        delete *actorIterator;
+        if (*actorIterator != nullptr)
+            destroyActor(*actorIterator);
+    for (auto actorIterator = m_spawnQueue.begin(); actorIterator != m_spawnQueue.end(); ++actorIterator)
+        destroyActor(*actorIterator);
+    m_spawnQueue.clear();
+    m_killQueue.clear();
+    for (int kind = 0; kind < KIND_COUNT; kind++)
+    {
+        m_activeActors[kind].clear();
+    }
+    m_tickHits.clear();
+    m_sensorsInside.clear();
     m_actors.clear();
+    m_levelArena.release();
+    for (int kind = 0; kind < KIND_COUNT; kind++)
+        m_actorPools[kind].release();
+    m_player = ActorHandle();
+    m_nextSequence = 0;
+    m_grid.clear();
+    m_terrain.clear();
+    m_triggers.clear();
+    m_observation.clear();
+    m_levelTemplate.reset();
+    m_changedActors.clear();
+    m_actorsHash = 0;
+}
+
+ActorHandle StudentWorld::addActor(Actor* actor)
+{
+    // the sequence, taken at construction, keeps grid query results in actor order
+    actor->m_handle = m_actors.insert(actor);
+    m_grid.insert(actor);
+    m_observation.add(s_observationChannels[actor->getKind()], actor->getX(), actor->getY());
+    unsigned volumes = s_triggerVolumes[actor->getKind()];
+    if (volumes != TRIGGER_NONE)
+    {
+        m_triggers.add(actor, volumes, s_sightHeights[actor->getKind()]);
+    }
+    if (!actor->isInert())
+    {
+        // newest sequence, so appending keeps the active set in actor order
+        actor->m_active = true;
+        m_activeActors[actor->getKind()].push_back(actor);
+    }
+    if (m_stateHashing)
+    {
+        actor->m_stateHash = 0;
+        rehashActor(actor);
+    }
+    return actor->m_handle;
+}
+
+void StudentWorld::addTerrain(Actor* actor, int gx, int gy)
+{
+    // terrain never moves, so it lives in the bitboard instead of the grid, and the template's observation has it already
+    actor->m_handle = m_actors.insert(actor);
+    m_terrain.set(gx, gy, actor);
+}
+
+void StudentWorld::destroyActor(Actor* actor)
+{
+    // terrain memory goes back with the whole arena in cleanUp()
+    bool pooled = actor->m_pooled;
+    ActorKind kind = actor->getKind();
+    actor->~Actor();
+    if (pooled)
+    {
+        m_actorPools[kind].deallocate(actor);
+    }
+}
+
+void StudentWorld::writeEgocentricObservation(unsigned char* cells) const
+{
+    PeachActor* player = getPlayer();
+    if (player == nullptr)
+    {
+        memset(cells, 0, EGOCENTRIC_OBSERVATION_SIZE);
+        return;
+    }
+    m_observation.copyEgocentricTo(player->getX(), player->getY(), cells);
 }
 
-void StudentWorld::addActor(Actor* actor)
+PeachActor* StudentWorld::getPlayer() const
 {
-    m_actors.push_back(actor);
+    return static_cast<PeachActor*>(m_actors.get(m_player));
+}
+
+void StudentWorld::actorMoved(Actor* actor, double oldX, double oldY)
+{
+    m_grid.move(actor, oldX, oldY);
+    m_observation.move(s_observationChannels[actor->getKind()], oldX, oldY, actor->getX(), actor->getY());
+    if (s_triggerVolumes[actor->getKind()] & TRIGGER_BODY)
+    {
+        m_triggers.moved(actor, oldX, oldY);
+    }
 }
 
 void StudentWorld::removeDeadActors()
 {
-    list<Actor*>::const_iterator actorIterator = m_actors.cbegin();
-    while (actorIterator != m_actors.cend())
+    if (m_killQueue.empty())
     {
-        if (!((*actorIterator)->isAlive()))
+        return;
+    }
+    // dead actors leave the active set before they are destroyed
+    for (auto actorIterator = m_killQueue.begin(); actorIterator != m_killQueue.end(); ++actorIterator)
+    {
+        (*actorIterator)->m_active = false;
+    }
+    updateActiveActors();
+    for (auto actorIterator = m_killQueue.begin(); actorIterator != m_killQueue.end(); ++actorIterator)
+    {
+        Actor* actor = *actorIterator;
+        m_grid.remove(actor);
+        m_observation.remove(s_observationChannels[actor->getKind()], actor->getX(), actor->getY());
+        unsigned volumes = s_triggerVolumes[actor->getKind()];
+        if (volumes != TRIGGER_NONE)
+        {
+            m_triggers.remove(actor, volumes);
+        }
+        m_actors.erase(actor->m_handle);
+        m_actorsHash ^= actor->m_stateHash;
+        destroyActor(actor);
+    }
+    m_killQueue.clear();
+    m_actors.compact();
+}
+
+void StudentWorld::addSpawnedActors()
+{
+    for (auto actorIterator = m_spawnQueue.begin(); actorIterator != m_spawnQueue.end(); ++actorIterator)
+    {
+        addActor(*actorIterator);
+    }
+    m_spawnQueue.clear();
+}
+
+void StudentWorld::updateActiveActors()
+{
+    for (int kind = 0; kind < KIND_COUNT; kind++)
+    {
+        vector<Actor*>& actors = m_activeActors[kind];
+        actors.erase(remove_if(actors.begin(), actors.end(), [](Actor* actor) { return !actor->m_active; }), actors.end());
+    }
+}
+
+void StudentWorld::queryActorsAt(double x, double y, double width, double height, unsigned categories, vector<Actor*>& result)
+{
+    // terrain and moving actors merged back into list order so dispatch order is unchanged
+    m_grid.query(x, y, width, height, categories, result);
+    if ((categories & CATEGORY_TERRAIN) == 0)
+    {
+        return;
+    }
+    size_t moving = result.size();
+    m_terrain.collect(x, y, width, height, result);
+    if (result.size() != moving)
+    {
+        sort(result.begin(), result.end(), [](Actor* a, Actor* b) { return a->getSequence() < b->getSequence(); });
+    }
+}
+
+void StudentWorld::findTriggers(bool beforePlayer)
+{
+    // one query finds every sensor holding the player, of which only those on the asked side of it are kept
+    unsigned int playerSequence = getPlayer()->getSequence();
+    m_triggers.query(getPlayer(), m_playerTriggers);
+    for (auto hitIterator = m_playerTriggers.begin(); hitIterator != m_playerTriggers.end(); ++hitIterator)
+    {
+        if ((hitIterator->actor->getSequence() < playerSequence) == beforePlayer)
+        {
+            hitIterator->entered = hitIterator->volumes & ~hitIterator->actor->m_playerInside;
+            m_tickHits.push_back(*hitIterator);
+        }
+    }
+    if (beforePlayer)
+    {
+        return;
+    }
+
+    // every hit of the tick is known, so the sensors inside can be brought up to date; those that died since the
+    // last tick are gone from the slot map, so their handles no longer resolve
+    for (auto handleIterator = m_sensorsInside.begin(); handleIterator != m_sensorsInside.end(); ++handleIterator)
+    {
+        Actor* sensor = m_actors.get(*handleIterator);
+        if (sensor != nullptr)
+        {
+            sensor->m_playerInside = TRIGGER_NONE;
+            actorChanged(sensor);
+        }
+    }
+    m_sensorsInside.clear();
+    for (auto hitIterator = m_tickHits.begin(); hitIterator != m_tickHits.end(); ++hitIterator)
+    {
+        Actor* sensor = hitIterator->actor;
+        sensor->m_playerInside = hitIterator->volumes;
+        actorChanged(sensor);
+        m_sensorsInside.push_back(sensor->getHandle());
+    }
+}
+
+StudentWorld::Sweep& StudentWorld::sweepActor(Actor* actor, double dx, double dy)
+{
+    // the swept box plus a pixel on every side, enough for the floor and leading edge probes; terrain is
+    // answered by the bitboard, so only the moving actors it could bonk or be blocked by are gathered
+    double x = actor->getX();
+    double y = actor->getY();
+    double left = min(x, x + dx) - 1;
+    double bottom = min(y, y + dy) - 1;
+    double width = fabs(dx) + SPRITE_WIDTH + 2;
+    double height = fabs(dy) + SPRITE_HEIGHT + 2;
+    m_grid.query(left, bottom, width, height, s_bonkMasks[actor->getKind()] | BLOCKING_CATEGORIES, m_sweep.m_nearby);
+    m_sweep.m_world = this;
+    m_sweep.m_actor = actor;
+    return m_sweep;
+}
+
+bool StudentWorld::Sweep::isBlockedAt(double x, double y, double width, double height) const
+{
+    if (m_world->m_terrain.isSolidAt(x, y, width, height))
+    {
+        return true;
+    }
+    for (auto actorIterator = m_nearby.begin(); actorIterator != m_nearby.end(); ++actorIterator)
+    {
+        if ((*actorIterator != m_actor) && (*actorIterator)->isBlocking())
+        {
+            if ((*actorIterator)->isOverlappingSpace(x, y, width, height))
+            {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+bool StudentWorld::Sweep::moveTo(double x, double y)
+{
+    // the moving actors already gathered plus the terrain under the destination, back in actor order for the bonks
+    vector<Actor*>& touching = m_world->m_candidates;
+    touching.clear();
+    for (auto actorIterator = m_nearby.begin(); actorIterator != m_nearby.end(); ++actorIterator)
+    {
+        if ((*actorIterator != m_actor) && (*actorIterator)->isOverlappingSpace(x, y, SPRITE_WIDTH, SPRITE_HEIGHT))
         {
-            delete* actorIterator;
-            actorIterator = m_actors.erase(actorIterator);
+            touching.push_back(*actorIterator);
         }
-        else {
-            ++actorIterator;
+    }
+    size_t moving = touching.size();
+    m_world->m_terrain.collect(x, y, SPRITE_WIDTH, SPRITE_HEIGHT, touching);
+    if (touching.size() != moving)
+    {
+        sort(touching.begin(), touching.end(), [](Actor* a, Actor* b) { return a->getSequence() < b->getSequence(); });
+    }
+
+    bool canMove = true;
+    for (auto actorIterator = touching.begin(); actorIterator != touching.end(); ++actorIterator)
+    {
+        m_actor->bonk(*actorIterator);
+        if ((*actorIterator)->isBlocking())
+        {
+            canMove = false;
         }
     }
+    m_world->bonkUnbuiltTerrain(m_actor, x, y, canMove);
+    if (canMove)
+    {
+        m_actor->moveTo(x, y);
+    }
+    return canMove;
 }
 
 bool StudentWorld::damageActorsTouching(Actor* actor)
 {
     bool damageDone = false;
-    for (auto actorIterator = m_actors.begin(); actorIterator != m_actors.end(); ++actorIterator)
+    queryActorsAt(actor->getX(), actor->getY(), SPRITE_WIDTH, SPRITE_HEIGHT, s_damageMasks[actor->getKind()], m_candidates);
+    for (auto actorIterator = m_candidates.begin(); actorIterator != m_candidates.end(); ++actorIterator)
     {
         if (*actorIterator != actor)
         {
@@ -177,7 +1001,13 @@ bool StudentWorld::damageActorsTouching(Actor* actor)
 
 bool StudentWorld::anyOtherBlockingActorsAt(Actor* thisActor, double x, double y) 
 {
-    for (auto actorIterator = m_actors.begin(); actorIterator != m_actors.end(); ++actorIterator)
+    // only moving actors ask, so the terrain never has to exclude the asking actor
+    if (m_terrain.isSolidAt(x, y, SPRITE_WIDTH, SPRITE_HEIGHT))
+    {
+        return true;
+    }
+    m_grid.query(x, y, SPRITE_WIDTH, SPRITE_HEIGHT, BLOCKING_CATEGORIES, m_candidates);
+    for (auto actorIterator = m_candidates.begin(); actorIterator != m_candidates.end(); ++actorIterator)
     {
         if (*actorIterator != thisActor)
         {
@@ -195,7 +1025,12 @@ bool StudentWorld::anyOtherBlockingActorsAt(Actor* thisActor, double x, double y
 
 bool StudentWorld::isSpaceUnderActorAt(Actor* actor, double x, double y, double width, int steps)
 {
-    for (auto actorIterator = m_actors.begin(); actorIterator != m_actors.end(); ++actorIterator)
+    if (m_terrain.isSolidAt(x, y - steps, width, 1))
+    {
+        return false;
+    }
+    m_grid.query(x, y - steps, width, 1, BLOCKING_CATEGORIES, m_candidates);
+    for (auto actorIterator = m_candidates.begin(); actorIterator != m_candidates.end(); ++actorIterator)
     {
         if ((*actorIterator != actor) && (*actorIterator)->isBlocking())
         {
@@ -211,7 +1046,9 @@ bool StudentWorld::isSpaceUnderActorAt(Actor* actor, double x, double y, double
 bool StudentWorld::moveActor(Actor* actor, double x, double y)
 {
     bool canMove = true;
-    for (auto actorIterator = m_actors.begin(); actorIterator != m_actors.end(); ++actorIterator)
+    // bonks never query the world, so the candidates stay valid while they are dispatched
+    queryActorsAt(x, y, SPRITE_WIDTH, SPRITE_HEIGHT, s_bonkMasks[actor->getKind()] | BLOCKING_CATEGORIES, m_candidates);
+    for (auto actorIterator = m_candidates.begin(); actorIterator != m_candidates.end(); ++actorIterator)
     {
         if (*actorIterator != actor)
         {
@@ -225,6 +1062,7 @@ bool StudentWorld::moveActor(Actor* actor, double x, double y)
             }
         }
     }
+    bonkUnbuiltTerrain(actor, x, y, canMove);
     if (canMove) 
     {
         actor->moveTo(x, y);
@@ -232,15 +1070,40 @@ bool StudentWorld::moveActor(Actor* actor, double x, double y)
     return canMove;
 }
 
+void StudentWorld::bonkUnbuiltTerrain(Actor* actor, double x, double y, bool& canMove)
+{
+    // shared terrain has no actors to bonk, so each solid cell without one gets the bonk a block or pipe would
+    for (int cells = m_terrain.countUnbuiltAt(x, y, SPRITE_WIDTH, SPRITE_HEIGHT); cells > 0; cells--)
+    {
+        ObstacleActor::obstacleBonkedBy(this, actor);
+        canMove = false;
+    }
+}
+
 void StudentWorld::updateGameStats()
 {
+    // the text is only rebuilt when something shown in it changed, keeping string building out of most ticks;
+    // a silent world shows nothing, so the first update once it is heard again catches up
+    if (isSilent())
+    {
+        return;
+    }
+    PeachActor* player = getPlayer();
+    long long statsKey = ((((long long)getScore() * 128 + getLevel()) * 128 + getLives()) * 8)
+        + (player->hasStarPower() ? 4 : 0) + (player->hasShootPower() ? 2 : 0) + (player->hasJumpPower() ? 1 : 0);
+    if (statsKey == m_statsKey)
+    {
+        return;
+    }
+    m_statsKey = statsKey;
+
     std::stringstream stream;
     stream << "Lives: " << getLives();
     stream << "  Level: " << std::setw(2) << std::setfill('0') << getLevel();
     stream << "  Points: " << std::setw(6) << std::setfill('0') << getScore();
-    if (m_player->hasStarPower()) stream << " StarPower!";
-    if (m_player->hasShootPower()) stream << " ShootPower!";
-    if (m_player->hasJumpPower()) stream << " JumpPower!";
+    if (player->hasStarPower()) stream << " StarPower!";
+    if (player->hasShootPower()) stream << " ShootPower!";
+    if (player->hasJumpPower()) stream << " JumpPower!";
     setGameStatText(stream.str());
 }
 
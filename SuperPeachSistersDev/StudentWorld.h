@@ -2,23 +2,38 @@
 #define STUDENTWORLD_H_
 
 #include "GameWorld.h"
-#include "Level.h"
+#include "LevelTemplate.h"
 #include "Actor.h"
+#include "ActorAllocator.h"
+#include "ActorKind.h"
+#include "ActorSlotMap.h"
+#include "SpatialGrid.h"
+#include "TerrainMap.h"
+#include "TriggerIndex.h"
+#include "ObservationGrid.h"
+#include "WorldRandom.h"
+#include "WorldSnapshot.h"
+#include "Replay.h"
 #include <string>
-#include <list>
+#include <vector>
+#include <new>
+#include <random>
+#include <cstdint>
+#include <memory>
 
 // Students:  Add code to this file, StudentWorld.cpp, Actor.h, and Actor.cpp
 class Actor;
 class PeachActor;
 
 class StudentWorld;
+template <class... Types> struct ActorTypeList;
 
 const bool GAME_ACTION = true;
 
 class StudentWorld : public GameWorld
 {
 public:
-	StudentWorld(std::string assetPath) : GameWorld(assetPath) { }
+	StudentWorld(std::string assetPath) : GameWorld(assetPath), m_seed(std::random_device()()) { }
 	~StudentWorld() 
 	{ 
 		cleanUp(); 
@@ -28,13 +43,91 @@ public:
 	virtual int move();
 	virtual void cleanUp();
 
-	void addActor(Actor* actor);
+	// Moves the world up to maxTicks ticks in one call, pressing keys[t % keyCount] on tick t in place of the
+	// host's keys (0 for none; no keys at all means none pressed), so one key is an action repeated for the whole
+	// run and a longer list is a script played on a loop. The run ends early when move() reports the end of the
+	// life, level or game, or when any condition in stopOn is met; the result totals what happened. A world with
+	// no level in play makes no moves and reports a level error.
+	enum RunStop
+	{
+		STOP_ON_SCORE = 1 << 0,		// the score changed
+		STOP_ON_HIT = 1 << 1		// Peach lost hit points
+	};
+	struct RunResult
+	{
+		int status;					// from the last move()
+		int ticks;					// moves made
+		int reward;					// score gained
+		unsigned stoppedBy;			// the RunStop conditions met on the last tick, if any
+	};
+	RunResult run(const int* keys, int keyCount, int maxTicks, unsigned stopOn = 0);
+
+	// Peach reads keys here, so a run can script them
+	bool getKey(int& value);
+
+	ActorHandle addActor(Actor* actor);
 	void removeDeadActors();
+	void addSpawnedActors();
+
+	// Terrain loaded with the level comes from the level arena, which cleanUp() releases in one go
+	template <class ActorType>
+	ActorType* createTerrainActor(int x, int y)
+	{
+		ActorType* actor = new (m_levelArena.allocate(sizeof(ActorType))) ActorType(this, x, y);
+		actor->m_kind = ActorType::KIND;
+		actor->m_category = ActorType::CATEGORY;
+		return actor;
+	}
+
+	// Every other actor comes from the pool for its kind, so the actors ticked together sit together in memory
+	template <class ActorType, class... Args>
+	ActorType* createActor(Args... args)
+	{
+		ActorType* actor = new (m_actorPools[ActorType::KIND].allocate(sizeof(ActorType))) ActorType(this, args...);
+		actor->m_kind = ActorType::KIND;
+		actor->m_category = ActorType::CATEGORY;
+		actor->m_pooled = true;
+		return actor;
+	}
+
+	// Actors spawned during play wait in the spawn queue until the tick's actors have all moved, so they first
+	// act on the following tick
+	template <class ActorType, class... Args>
+	ActorType* spawnActor(Args... args)
+	{
+		ActorType* actor = createActor<ActorType>(args...);
+		m_spawnQueue.push_back(actor);
+		return actor;
+	}
+
+	// Bonk and damage dispatch through tables keyed by the kinds of both actors
+	bool bonk(Actor* bonker, Actor* bonked);
+	bool damage(Actor* damager, Actor* damaged);
+
+	void actorMoved(Actor* actor, double oldX, double oldY);
+	void actorDied(Actor* actor) { m_killQueue.push_back(actor); }
 
 	bool anyOtherBlockingActorsAt(Actor* actor, double x = 0, double y = 0);
 	bool isSpaceUnderActorAt(Actor* actor, double x, double y, double width = SPRITE_WIDTH, int steps = 1);
 
 	bool moveActor(Actor* actor, double x, double y);
+
+	// One pass collision query for an actor about to move: the actors near the box swept from its position through
+	// (dx, dy) are gathered once, then the mover's blocking tests and its final move are answered from that set.
+	// Steps are always shorter than a sprite, so testing the destination finds every contact a continuous sweep would.
+	class Sweep
+	{
+	public:
+		bool isBlockedAt(double x, double y, double width, double height) const;
+		bool isSpaceUnder(double x, double y, double width, int steps) const { return !isBlockedAt(x, y - steps, width, 1); }
+		bool moveTo(double x, double y);
+	private:
+		friend class StudentWorld;
+		StudentWorld* m_world = nullptr;
+		Actor* m_actor = nullptr;
+		std::vector<Actor*> m_nearby;
+	};
+	Sweep& sweepActor(Actor* actor, double dx, double dy);
 	bool damageActorsTouching(Actor* actor);
 
 	void setLevelCompleted() { m_levelCompleted = true; }
@@ -44,16 +137,157 @@ public:
 
 	void updateGameStats();
 
-	PeachActor* getPlayer() const { return m_player; }
+	// Levels come from templates shared by every world playing them. A world that shares the terrain too never
+	// builds the stateless blocks and pipes, standing in for them itself; nothing draws them then, so the GLUT game
+	// leaves this off and headless runs turn it on
+	void setTerrainShared(bool shared) { m_terrainShared = shared; }
+
+	// Random draws come from a generator reseeded by every init() from the world's seed, so identical seeds and
+	// identical keys give identical runs; the seed is picked at random until one is set
+	void setSeed(uint64_t seed) { m_seed = seed; }
+	uint64_t getSeed() const { return m_seed; }
+	const WorldRandom& getRandom() const { return m_random; }
+	// Switches seeds mid level: draws from now on come from the new seed, and what was drawn already stays
+	void reseed(uint64_t seed) { m_seed = seed; m_random.setSeed(m_seed ^ WorldRandom::mix(m_levelStarts)); }
+
+	// Actors take their sequence as they are constructed, so it is already theirs for any draws made on the way
+	unsigned int newActorSequence() { return ++m_nextSequence; }
+
+	// The world for agents, kept up to date as actors come, go and move (see ObservationGrid.h): the whole level,
+	// or the egocentric window centred on the player
+	static const int OBSERVATION_SIZE = ObservationGrid::SIZE;
+	static const int EGOCENTRIC_OBSERVATION_SIZE = ObservationGrid::EGOCENTRIC_SIZE;
+	const ObservationGrid& getObservation() const { return m_observation; }
+	void writeObservation(unsigned char* cells) const { m_observation.copyTo(cells); }
+	void writeEgocentricObservation(unsigned char* cells) const;
+
+	// Compact binary snapshots of everything that decides how play goes on (see WorldSnapshot.h), taken between
+	// ticks of a level in play. Terrain is named by the level rather than written out, so restoring rebuilds it
+	// from the shared template. A restored world plays on exactly as the saved one would, whether or not either
+	// shares terrain; restoring fails, leaving the world cleaned up, when the data is not a snapshot of a level
+	// this world can load.
+	bool saveSnapshot(std::vector<unsigned char>& bytes) const;
+	bool restoreSnapshot(const unsigned char* bytes, size_t size);
+
+	// Forks for search: a new world, or a world recycled from an earlier fork, left exactly where this one is,
+	// with the same terrain sharing but no host, so it plays no sound, shows nothing and reads keys only from
+	// run(). Only the actors that change are copied; the level template, with its terrain rows, entries and
+	// observation, is shared, and no global state is touched, so any number of forks can be stepped on any
+	// threads and thrown away. A recycled world keeps its memory pools warm. Fails, giving null or false, when
+	// this world has no level in play.
+	std::unique_ptr<StudentWorld> fork() const;
+	bool forkInto(StudentWorld& child) const;
+
+	// A 64 bit hash of the state a snapshot holds, equal for worlds whose snapshots are equal. With hashing on,
+	// each actor's share is updated only when the actor may have changed: when it acts, is bonked, damaged or
+	// triggered, or the player's sensors change, and when it is spawned or removed; the hash is the XOR of those
+	// shares and of the game's progress. Off by default, as it costs a little every tick; asking for the hash
+	// turns it on, and forks inherit it.
+	void setStateHashing(bool hashing);
+	uint64_t getStateHash();
+
+	// Replays (see Replay.h): a recorder is told every tick and key read, and a player hands out the recorded
+	// keys in place of the host's, though host keys are still read so the GLUT game can be quit. Either is left
+	// to its owner, like the host, and forks take neither.
+	void setReplayRecorder(ReplayRecorder* recorder) { m_replayRecorder = recorder; }
+	void setReplayPlayer(ReplayPlayer* player) { m_replayPlayer = player; }
+
+	PeachActor* getPlayer() const;
+	Actor* getActor(ActorHandle handle) const { return m_actors.get(handle); }
 
 private:
-	PeachActor* m_player = 0;
+	ActorHandle m_player;
 	bool m_levelCompleted = false;
 	bool m_playerDied = false;
 	bool m_playerWon = false;
+	long long m_statsKey = -1;
 
 	std::string getLevelFileName(int level);
-	std::list<Actor*> m_actors;
+	const int* m_runKeys = nullptr;
+	int m_runKeyCount = 0;
+	int m_runTick = 0;
+	ReplayRecorder* m_replayRecorder = nullptr;
+	ReplayPlayer* m_replayPlayer = nullptr;
+	std::shared_ptr<const LevelTemplate> m_levelTemplate;
+	// the template last loaded, kept through cleanUp() so restarting a level looks nothing up
+	std::shared_ptr<const LevelTemplate> m_lastTemplate;
+	int m_lastTemplateLevel = 0;
+	bool m_terrainShared = false;
+	bool loadLevel(std::shared_ptr<const LevelTemplate> levelTemplate = nullptr);
+	bool restoreSnapshot(SnapshotReader& reader, std::shared_ptr<const LevelTemplate> levelTemplate);
+	void addLevelActor(const LevelTemplate::Entry& entry);
+	void reserveGridRows(const std::vector<LevelTemplate::Entry>& entries);
+	Actor* createActorOfKind(ActorKind kind, int x, int y, int direction);
+	void writeProgress(SnapshotWriter& writer) const;
+	void writeActorRecord(const Actor* actor, SnapshotWriter& writer) const;
+
+	// actors that may have changed since the hash was last brought up to date
+	bool m_stateHashing = false;
+	uint64_t m_actorsHash = 0;
+	std::vector<Actor*> m_changedActors;
+	void actorChanged(Actor* actor);
+	uint64_t hashActor(const Actor* actor) const;
+	void rehashActor(Actor* actor);
+	void rehashChangedActors();
+	void rehashAllActors();
+	void bonkUnbuiltTerrain(Actor* actor, double x, double y, bool& canMove);
+	void addTerrain(Actor* actor, int gx, int gy);
+	void destroyActor(Actor* actor);
+	void queryActorsAt(double x, double y, double width, double height, unsigned categories, std::vector<Actor*>& result);
+	ActorSlotMap m_actors;
+	LevelArena m_levelArena;
+	ActorPool m_actorPools[KIND_COUNT];
+
+	// spawns and deaths from a tick are committed together once every actor has moved
+	std::vector<Actor*> m_spawnQueue;
+	std::vector<Actor*> m_killQueue;
+
+	// the actors ticked by move(), one list per kind in actor order; an actor joins when added unless it is inert,
+	// and leaves when it dies
+	std::vector<Actor*> m_activeActors[KIND_COUNT];
+	void updateActiveActors();
+
+	// move() ticks the active actors in actor order, merging the per-kind lists by sequence; each turn goes through
+	// the actor's kind's entry, which calls its class's doSomething directly, after calling back the sensors the
+	// player set off that come before it
+	typedef void (StudentWorld::*TickFunction)(Actor* actor);
+	typedef void (StudentWorld::*TriggerFunction)(const TriggerHit& hit);
+	struct TickCursor
+	{
+		unsigned int sequence;
+		int kind;
+		size_t index;
+	};
+	template <class ActorType> void tickActor(Actor* actor);
+	template <class ActorType> void triggerActor(const TriggerHit& hit);
+	void triggerActorsUpTo(unsigned int sequence, size_t& nextHit);
+	template <class... Types> static std::vector<TickFunction> makeTickFunctions(ActorTypeList<Types...>);
+	template <class... Types> static std::vector<TriggerFunction> makeTriggerFunctions(ActorTypeList<Types...>);
+	static const std::vector<TickFunction> s_tickFunctions;
+	static const std::vector<TriggerFunction> s_triggerFunctions;
+	std::vector<TickCursor> m_tickCursors;
+	bool isTickOver() const { return m_playerDied || m_levelCompleted || m_playerWon; }
+	unsigned int m_nextSequence = 0;
+
+	uint64_t m_seed;
+	unsigned int m_levelStarts = 0;
+	WorldRandom m_random;
+
+	// collision queries test the static terrain bitboard and then only the moving actors bucketed near the space
+	TerrainMap m_terrain;
+	SpatialGrid m_grid;
+	ObservationGrid m_observation;
+	std::vector<Actor*> m_candidates;
+	Sweep m_sweep;
+
+	// the sensors holding the player are found twice a tick, as each would have found it at its own turn: those
+	// before it in actor order as the tick starts, the rest once it has moved. The hits wait in actor order for
+	// their sensor's turn, and the sensors inside last tick are remembered by handle to tell which were entered
+	TriggerIndex m_triggers;
+	std::vector<TriggerHit> m_tickHits;
+	std::vector<TriggerHit> m_playerTriggers;
+	std::vector<ActorHandle> m_sensorsInside;
+	void findTriggers(bool beforePlayer);
 };
 
 #define MINIMUM_LEVEL 1
@@ -0,0 +1,116 @@
+#include "TerrainMap.h"
+#include "Actor.h"
+#include "LevelTemplate.h"
+#include <algorithm>
+#include <cmath>
+using namespace std;
+
+static const uint32_t s_noRows[GRID_HEIGHT] = { };
+
+void TerrainMap::clear()
+{
+	m_level = nullptr;
+	m_rows = s_noRows;
+	for (int gy = 0; gy < GRID_HEIGHT; gy++)
+	{
+		m_builtRows[gy] = 0;
+	}
+	m_actors.clear();
+}
+
+void TerrainMap::setLevel(const LevelTemplate* level)
+{
+	clear();
+	m_level = level;
+	m_rows = level->getTerrainRows();
+	m_actors.assign(level->getEntries().size(), nullptr);
+}
+
+void TerrainMap::set(int gx, int gy, Actor* actor)
+{
+	m_actors[m_level->getTerrainEntry(gx, gy)] = actor;
+	m_builtRows[gy] |= (uint32_t)1 << gx;
+}
+
+bool TerrainMap::isSolidCell(int gx, int gy) const
+{
+	if (gx < 0 || gx >= GRID_WIDTH || gy < 0 || gy >= GRID_HEIGHT)
+	{
+		return false;
+	}
+	return (m_rows[gy] >> gx) & 1;
+}
+
+bool TerrainMap::rowsAndMask(double x, double y, double width, double height, int& gy0, int& gy1, uint32_t& mask) const
+{
+	// terrain cells are sprite aligned, so a space overlaps cell g exactly when g lies in [floor(x / w), ceil((x + width) / w) - 1]
+	int gx0 = max(0, (int)floor(x / SPRITE_WIDTH));
+	int gx1 = min(GRID_WIDTH - 1, (int)ceil((x + width) / SPRITE_WIDTH) - 1);
+	gy0 = max(0, (int)floor(y / SPRITE_HEIGHT));
+	gy1 = min(GRID_HEIGHT - 1, (int)ceil((y + height) / SPRITE_HEIGHT) - 1);
+	if (gx0 > gx1 || gy0 > gy1)
+	{
+		return false;
+	}
+	uint32_t upTo = (gx1 == 31) ? 0xFFFFFFFFu : (((uint32_t)1 << (gx1 + 1)) - 1);
+	mask = upTo & ~(((uint32_t)1 << gx0) - 1);
+	return true;
+}
+
+bool TerrainMap::isSolidAt(double x, double y, double width, double height) const
+{
+	int gy0, gy1;
+	uint32_t mask;
+	if (!rowsAndMask(x, y, width, height, gy0, gy1, mask))
+	{
+		return false;
+	}
+	for (int gy = gy0; gy <= gy1; gy++)
+	{
+		if (m_rows[gy] & mask)
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+void TerrainMap::collect(double x, double y, double width, double height, vector<Actor*>& result) const
+{
+	int gy0, gy1;
+	uint32_t mask;
+	if (!rowsAndMask(x, y, width, height, gy0, gy1, mask))
+	{
+		return;
+	}
+	for (int gy = gy0; gy <= gy1; gy++)
+	{
+		uint32_t built = m_builtRows[gy] & mask;
+		for (int gx = 0; gx < GRID_WIDTH; gx++)
+		{
+			if ((built >> gx) & 1)
+			{
+				result.push_back(m_actors[m_level->getTerrainEntry(gx, gy)]);
+			}
+		}
+	}
+}
+
+int TerrainMap::countUnbuiltAt(double x, double y, double width, double height) const
+{
+	int gy0, gy1;
+	uint32_t mask;
+	if (!rowsAndMask(x, y, width, height, gy0, gy1, mask))
+	{
+		return 0;
+	}
+	int count = 0;
+	for (int gy = gy0; gy <= gy1; gy++)
+	{
+		for (uint32_t unbuilt = m_rows[gy] & ~m_builtRows[gy] & mask; unbuilt != 0; unbuilt &= unbuilt - 1)
+		{
+			count++;
+		}
+	}
+	return count;
+}
@@ -0,0 +1,45 @@
+#ifndef TERRAINMAP_H_
+#define TERRAINMAP_H_
+
+#include "GameConstants.h"
+#include <cstdint>
+#include <vector>
+
+class Actor;
+class LevelTemplate;
+
+static_assert(GRID_WIDTH <= 32, "each terrain row must fit in a uint32_t");
+
+// Bitboard of the level's terrain, shared with its template; bit gx of row gy is set when a terrain cell is there,
+// so testing a space against the terrain is a mask per row instead of a scan over the actors. The world records
+// the terrain actors it builds; solid cells without one are stateless terrain the world stands in for.
+//
+class TerrainMap
+{
+public:
+	TerrainMap() { clear(); }
+
+	void clear();
+	void setLevel(const LevelTemplate* level);
+	void set(int gx, int gy, Actor* actor);
+	// The actor built for a template entry, or null
+	Actor* getActor(int entry) const { return m_actors[entry]; }
+
+	bool isSolidCell(int gx, int gy) const;
+	// Pixel precise test of a space against the terrain, using the same half open overlap as Actor::isOverlappingSpace
+	bool isSolidAt(double x, double y, double width, double height) const;
+	// Appends the terrain actors overlapping the space, row by row
+	void collect(double x, double y, double width, double height, std::vector<Actor*>& result) const;
+	// Counts the solid cells overlapping the space that have no actor
+	int countUnbuiltAt(double x, double y, double width, double height) const;
+
+private:
+	bool rowsAndMask(double x, double y, double width, double height, int& gy0, int& gy1, uint32_t& mask) const;
+
+	const LevelTemplate* m_level;
+	const uint32_t* m_rows;
+	uint32_t m_builtRows[GRID_HEIGHT];
+	std::vector<Actor*> m_actors;	// by the index of the cell's entry in the template
+};
+
+#endif // TERRAINMAP_H_
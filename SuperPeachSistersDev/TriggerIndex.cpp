@@ -0,0 +1,106 @@
+#include "TriggerIndex.h"
+#include "Actor.h"
+#include <algorithm>
+#include <cmath>
+#include <iterator>
+using namespace std;
+
+void TriggerIndex::rowsFor(double bottom, double top, int& row0, int& row1)
+{
+	// bands are half open, [bottom, top), like every other space in the world
+	row0 = min(GRID_HEIGHT - 1, max(0, (int)floor(bottom / SPRITE_HEIGHT)));
+	row1 = min(GRID_HEIGHT - 1, max(0, (int)ceil(top / SPRITE_HEIGHT) - 1));
+}
+
+void TriggerIndex::add(Actor* actor, unsigned volumes, double sightHeight)
+{
+	if (volumes & TRIGGER_BODY)
+	{
+		m_bodies.insert(actor);
+	}
+	if (volumes & TRIGGER_SIGHT)
+	{
+		SightBand band = { actor, actor->getY() - sightHeight, actor->getY() + sightHeight };
+		int row0, row1;
+		rowsFor(band.bottom, band.top, row0, row1);
+		for (int row = row0; row <= row1; row++)
+		{
+			m_sightRows[row].push_back(band);
+		}
+	}
+}
+
+void TriggerIndex::remove(Actor* actor, unsigned volumes)
+{
+	if (volumes & TRIGGER_BODY)
+	{
+		m_bodies.remove(actor);
+	}
+	if (volumes & TRIGGER_SIGHT)
+	{
+		// erased in place so every row stays in actor order
+		for (int row = 0; row < GRID_HEIGHT; row++)
+		{
+			vector<SightBand>& bands = m_sightRows[row];
+			bands.erase(remove_if(bands.begin(), bands.end(), [actor](const SightBand& band) { return band.actor == actor; }), bands.end());
+		}
+	}
+}
+
+void TriggerIndex::clear()
+{
+	m_bodies.clear();
+	for (int row = 0; row < GRID_HEIGHT; row++)
+	{
+		m_sightRows[row].clear();
+	}
+}
+
+void TriggerIndex::query(Actor* player, vector<TriggerHit>& hits)
+{
+	hits.clear();
+	m_bodies.query(player->getX(), player->getY(), SPRITE_WIDTH, SPRITE_HEIGHT, CATEGORY_ALL, m_candidates);
+	for (auto actorIterator = m_candidates.begin(); actorIterator != m_candidates.end(); ++actorIterator)
+	{
+		if ((*actorIterator)->isOverlapping(player))
+		{
+			hits.push_back({ *actorIterator, TRIGGER_BODY, 0 });
+		}
+	}
+
+	// a sight band holds the player when the player's height is inside it
+	double y = player->getY();
+	int row0, row1;
+	rowsFor(y, y + 1, row0, row1);
+	const vector<SightBand>& bands = m_sightRows[row0];
+	size_t bodies = hits.size();
+	for (auto bandIterator = bands.begin(); bandIterator != bands.end(); ++bandIterator)
+	{
+		if (y >= bandIterator->bottom && y < bandIterator->top)
+		{
+			hits.push_back({ bandIterator->actor, TRIGGER_SIGHT, 0 });
+		}
+	}
+	if (hits.size() == bodies || bodies == 0)
+	{
+		return;
+	}
+
+	// both lists are in actor order; merge them through a buffer kept between ticks, folding the volumes of a
+	// sensor found twice into one hit
+	m_merged.clear();
+	merge(hits.begin(), hits.begin() + bodies, hits.begin() + bodies, hits.end(), back_inserter(m_merged),
+		[](const TriggerHit& a, const TriggerHit& b) { return a.actor->getSequence() < b.actor->getSequence(); });
+	hits.clear();
+	for (auto hitIterator = m_merged.begin(); hitIterator != m_merged.end(); ++hitIterator)
+	{
+		if (!hits.empty() && hits.back().actor == hitIterator->actor)
+		{
+			hits.back().volumes |= hitIterator->volumes;
+		}
+		else
+		{
+			hits.push_back(*hitIterator);
+		}
+	}
+}
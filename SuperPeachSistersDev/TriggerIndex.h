@@ -0,0 +1,49 @@
+#ifndef TRIGGERINDEX_H_
+#define TRIGGERINDEX_H_
+
+#include "GameConstants.h"
+#include "SpatialGrid.h"
+#include <vector>
+
+class Actor;
+
+// A sensor set off by the player during one tick: the volumes the player is inside and which of them it just entered
+//
+struct TriggerHit
+{
+	Actor* actor;
+	unsigned volumes;
+	unsigned entered;
+};
+
+// Index of the trigger volumes registered by sensor actors, so the player is tested against only the sensors near it
+// once a tick instead of every sensor polling the player. Body volumes are the sensor's own sprite and follow it
+// through a grid of their own; sight volumes are bands the full width of the level, bucketed by the rows they cover.
+//
+class TriggerIndex
+{
+public:
+	void add(Actor* actor, unsigned volumes, double sightHeight);
+	void remove(Actor* actor, unsigned volumes);
+	void moved(Actor* actor, double oldX, double oldY) { m_bodies.move(actor, oldX, oldY); }
+	void clear();
+
+	// Collects the sensors with a volume holding the player, once each and in actor order; entered is left empty
+	void query(Actor* player, std::vector<TriggerHit>& hits);
+
+private:
+	struct SightBand
+	{
+		Actor* actor;
+		double bottom;
+		double top;
+	};
+	static void rowsFor(double bottom, double top, int& row0, int& row1);
+
+	SpatialGrid m_bodies;
+	std::vector<SightBand> m_sightRows[GRID_HEIGHT];
+	std::vector<Actor*> m_candidates;
+	std::vector<TriggerHit> m_merged;
+};
+
+#endif // TRIGGERINDEX_H_
@@ -0,0 +1,157 @@
+#include "WorkStealingPool.h"
+using namespace std;
+
+WorkStealingPool::WorkStealingPool(unsigned int threadCount)
+{
+	if (threadCount == 0)
+		threadCount = thread::hardware_concurrency();
+	if (threadCount == 0)
+		threadCount = 1;
+
+	for (unsigned int i = 0; i < threadCount; i++)
+		m_queues.push_back(unique_ptr<Queue>(new Queue));
+	  // queue 0 belongs to whoever calls run()
+	for (unsigned int i = 1; i < threadCount; i++)
+		m_threads.push_back(thread(&WorkStealingPool::workerLoop, this, i));
+}
+
+WorkStealingPool::~WorkStealingPool()
+{
+	{
+		lock_guard<mutex> lock(m_lock);
+		m_stopping = true;
+	}
+	m_wake.notify_all();
+	for (thread& t : m_threads)
+		t.join();
+}
+
+void WorkStealingPool::runJob(size_t count, size_t grain, JobFunction function, const void* job)
+{
+	if (count == 0)
+		return;
+	if (grain == 0)
+		grain = 1;
+
+	size_t chunks = (count + grain - 1) / grain;
+	m_jobFunction = function;
+	m_job = job;
+	m_error = nullptr;
+	m_failed.store(false);
+	m_remaining.store(chunks);
+
+	  // every queue was emptied by the last run, and keeps its capacity
+	for (unique_ptr<Queue>& queue : m_queues)
+	{
+		lock_guard<mutex> lock(queue->lock);
+		queue->chunks.clear();
+		queue->front = 0;
+	}
+
+	  // deal the chunks out round robin, so each queue starts with a share of the whole range
+	size_t queueCount = m_queues.size();
+	for (size_t i = 0; i < chunks; i++)
+	{
+		Queue& queue = *m_queues[i % queueCount];
+		size_t begin = i * grain;
+		size_t end = begin + grain < count ? begin + grain : count;
+		lock_guard<mutex> lock(queue.lock);
+		queue.chunks.push_back(Chunk{begin, end});
+	}
+
+	if (!m_threads.empty())
+	{
+		{
+			lock_guard<mutex> lock(m_lock);
+			m_generation++;
+		}
+		m_wake.notify_all();
+	}
+
+	runChunks(0);
+
+	exception_ptr error;
+	{
+		unique_lock<mutex> lock(m_lock);
+		m_done.wait(lock, [this] { return m_remaining.load() == 0; });
+		m_jobFunction = nullptr;
+		m_job = nullptr;
+		error = m_error;
+		m_error = nullptr;
+	}
+	if (error)
+		rethrow_exception(error);
+}
+
+void WorkStealingPool::workerLoop(unsigned int index)
+{
+	unsigned long seen = 0;
+	for (;;)
+	{
+		{
+			unique_lock<mutex> lock(m_lock);
+			m_wake.wait(lock, [this, seen] { return m_stopping || m_generation != seen; });
+			if (m_stopping)
+				return;
+			seen = m_generation;
+		}
+		runChunks(index);
+	}
+}
+
+bool WorkStealingPool::takeChunk(unsigned int index, Chunk& chunk)
+{
+	  // own work first, newest end first
+	{
+		Queue& own = *m_queues[index];
+		lock_guard<mutex> lock(own.lock);
+		if (own.chunks.size() > own.front)
+		{
+			chunk = own.chunks.back();
+			own.chunks.pop_back();
+			return true;
+		}
+	}
+
+	  // then the oldest chunk of the next queue that has any
+	size_t queueCount = m_queues.size();
+	for (size_t i = 1; i < queueCount; i++)
+	{
+		Queue& victim = *m_queues[(index + i) % queueCount];
+		lock_guard<mutex> lock(victim.lock);
+		if (victim.chunks.size() > victim.front)
+		{
+			chunk = victim.chunks[victim.front++];
+			return true;
+		}
+	}
+	return false;
+}
+
+void WorkStealingPool::runChunks(unsigned int index)
+{
+	Chunk chunk;
+	while (takeChunk(index, chunk))
+	{
+		  // once a chunk has thrown the rest are only counted off, and the first exception goes back to run()
+		if (!m_failed.load())
+		{
+			try
+			{
+				m_jobFunction(m_job, chunk.begin, chunk.end);
+			}
+			catch (...)
+			{
+				lock_guard<mutex> lock(m_lock);
+				if (!m_error)
+					m_error = current_exception();
+				m_failed.store(true);
+			}
+		}
+		if (m_remaining.fetch_sub(1) == 1)
+		{
+			lock_guard<mutex> lock(m_lock);
+			m_done.notify_all();
+		}
+	}
+}
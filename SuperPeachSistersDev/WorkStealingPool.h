@@ -0,0 +1,84 @@
+#ifndef WORKSTEALINGPOOL_H_
+#define WORKSTEALINGPOOL_H_
+
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <memory>
+#include <exception>
+#include <cstddef>
+
+// A fixed set of threads that run a range of jobs split into chunks. The chunks are dealt out to one queue per
+// thread; each thread works from the back of its own queue and, once that is empty, steals from the front of
+// the others', so a thread that draws slow chunks (worlds that reset, busy levels) is helped by the idle ones.
+// The calling thread works too, as queue 0, and run() returns only when every chunk is done.
+//
+class WorkStealingPool
+{
+public:
+	// threadCount counts the calling thread; 0 means one per hardware thread
+	explicit WorkStealingPool(unsigned int threadCount = 0);
+	~WorkStealingPool();
+
+	WorkStealingPool(const WorkStealingPool&) = delete;
+	WorkStealingPool& operator=(const WorkStealingPool&) = delete;
+
+	// Calls job(begin, end) for consecutive ranges of at most grain items covering [0, count). The job is called
+	// through a plain function pointer rather than wrapped, and the queues keep their memory, so a run allocates
+	// nothing once the pool has run as many chunks before. If a call throws, on any thread, the ranges not yet
+	// started are skipped and run() throws the first exception once every thread is done.
+	template <class Job>
+	void run(size_t count, size_t grain, const Job& job)
+	{
+		runJob(count, grain, &callJob<Job>, &job);
+	}
+
+	unsigned int getThreadCount() const { return (unsigned int)m_queues.size(); }
+
+private:
+	struct Chunk
+	{
+		size_t begin;
+		size_t end;
+	};
+
+	// chunks are only ever dealt in before a run and taken out during it, so a queue is the chunks not yet taken
+	// between front and the end; the owner takes from the end and thieves from the front
+	struct Queue
+	{
+		std::mutex lock;
+		std::vector<Chunk> chunks;
+		size_t front = 0;
+	};
+
+	typedef void (*JobFunction)(const void* job, size_t begin, size_t end);
+	template <class Job>
+	static void callJob(const void* job, size_t begin, size_t end)
+	{
+		(*static_cast<const Job*>(job))(begin, end);
+	}
+	void runJob(size_t count, size_t grain, JobFunction function, const void* job);
+
+	void workerLoop(unsigned int index);
+	bool takeChunk(unsigned int index, Chunk& chunk);
+	void runChunks(unsigned int index);
+
+	std::vector<std::unique_ptr<Queue>> m_queues;
+	std::vector<std::thread> m_threads;
+
+	std::mutex m_lock;
+	std::condition_variable m_wake;
+	std::condition_variable m_done;
+	unsigned long m_generation = 0;
+	bool m_stopping = false;
+
+	JobFunction m_jobFunction = nullptr;
+	const void* m_job = nullptr;
+	std::exception_ptr m_error;
+	std::atomic<bool> m_failed{false};
+	std::atomic<size_t> m_remaining{0};
+};
+
+#endif // WORKSTEALINGPOOL_H_
@@ -0,0 +1,50 @@
+#ifndef WORLDRANDOM_H_
+#define WORLDRANDOM_H_
+
+#include <cstdint>
+
+// Counter based random numbers owned by one world. A draw is a hash of the world's seed, a key naming who is
+// drawing and that drawer's own count of draws, so it does not depend on any other draw or on the order actors
+// are updated in, and worlds share no state however many run side by side.
+//
+class WorldRandom
+{
+public:
+	explicit WorldRandom(uint64_t seed = 0) { setSeed(seed); }
+
+	void setSeed(uint64_t seed) { m_seed = seed; m_key = mix(seed); }
+	uint64_t getSeed() const { return m_seed; }
+
+	uint64_t draw(uint64_t key, uint64_t counter) const
+	{
+		return mix(m_key ^ mix(key * 0x9e3779b97f4a7c15ULL + counter));
+	}
+
+	// Uniform int from min to max, inclusive
+	int randInt(uint64_t key, uint64_t counter, int min, int max) const
+	{
+		if (max < min)
+		{
+			int swap = min;
+			min = max;
+			max = swap;
+		}
+		uint64_t range = (uint64_t)((int64_t)max - min) + 1;
+		return (int)(min + (int64_t)(draw(key, counter) % range));
+	}
+
+	// SplitMix64 finaliser
+	static uint64_t mix(uint64_t x)
+	{
+		x += 0x9e3779b97f4a7c15ULL;
+		x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+		x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+		return x ^ (x >> 31);
+	}
+
+private:
+	uint64_t m_seed;
+	uint64_t m_key;
+};
+
+#endif // WORLDRANDOM_H_
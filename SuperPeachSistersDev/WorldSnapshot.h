@@ -0,0 +1,100 @@
+#ifndef WORLDSNAPSHOT_H_
+#define WORLDSNAPSHOT_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Byte streams for world snapshots (see StudentWorld::saveSnapshot). Integers are written little endian at
+// fixed widths whatever the machine, so a snapshot taken on one machine restores on another.
+//
+// Format version 1:
+//
+//   u32 magic, u16 version, u16 level, i16 lives, i32 score, u64 seed, u32 level starts, u32 next sequence
+//   u16 count, then for each template entry of stateful terrain, in entry order, that actor's kind state
+//   u16 count, then for each other live actor, in sequence order:
+//       u8 kind, u32 sequence, i16 x, i16 y, u8 flags (SNAPSHOT_FACING_LEFT, trigger volumes the player is
+//       inside shifted up by SNAPSHOT_INSIDE_SHIFT), i16 remaining jump distance, u32 random draws,
+//       then the kind's own state
+//
+// Blocks and pipes are never written: the level template they come from is named by the level number.
+//
+const uint32_t SNAPSHOT_MAGIC = 0x53535053;	// "SPSS"
+const uint16_t SNAPSHOT_VERSION = 1;
+const uint8_t SNAPSHOT_FACING_LEFT = 1 << 0;
+const int SNAPSHOT_INSIDE_SHIFT = 1;
+
+class SnapshotWriter
+{
+public:
+	explicit SnapshotWriter(std::vector<unsigned char>& bytes) : m_bytes(&bytes) { }
+	// A writer that keeps only an FNV-1a hash of what would have been written, so state hashes cover exactly
+	// what snapshots do
+	SnapshotWriter() : m_bytes(nullptr) { }
+
+	void putU8(unsigned value)
+	{
+		if (m_bytes != nullptr)
+			m_bytes->push_back((unsigned char)value);
+		else
+			m_hash = (m_hash ^ (unsigned char)value) * 0x100000001b3ULL;
+	}
+	void putU16(unsigned value) { putU8(value); putU8(value >> 8); }
+	void putU32(uint32_t value) { putU16(value); putU16(value >> 16); }
+	void putU64(uint64_t value) { putU32((uint32_t)value); putU32((uint32_t)(value >> 32)); }
+	void putI16(int value) { putU16((uint16_t)(int16_t)value); }
+	void putI32(int value) { putU32((uint32_t)value); }
+	void putBool(bool value) { putU8(value ? 1 : 0); }
+
+	uint64_t getHash() const { return m_hash; }
+
+private:
+	std::vector<unsigned char>* m_bytes;
+	uint64_t m_hash = 0xcbf29ce484222325ULL;
+};
+
+// Reads past the end give zeros and mark the reader failed, so callers check once at the end
+class SnapshotReader
+{
+public:
+	SnapshotReader(const unsigned char* bytes, size_t size) : m_bytes(bytes), m_size(size) { }
+
+	unsigned getU8()
+	{
+		if (m_offset >= m_size)
+		{
+			m_failed = true;
+			return 0;
+		}
+		return m_bytes[m_offset++];
+	}
+	unsigned getU16() { unsigned low = getU8(); return low | (getU8() << 8); }
+	uint32_t getU32() { uint32_t low = getU16(); return low | ((uint32_t)getU16() << 16); }
+	uint64_t getU64() { uint64_t low = getU32(); return low | ((uint64_t)getU32() << 32); }
+	int getI16() { return (int16_t)getU16(); }
+	int getI32() { return (int32_t)getU32(); }
+	bool getBool() { return getU8() != 0; }
+	// Passes over count bytes, giving the offset they start at, so a block can be copied out whole
+	size_t skip(size_t count)
+	{
+		size_t start = m_offset;
+		if (count > m_size - m_offset)
+		{
+			m_failed = true;
+			count = m_size - m_offset;
+		}
+		m_offset += count;
+		return start;
+	}
+
+	bool failed() const { return m_failed; }
+	bool atEnd() const { return m_offset == m_size; }
+
+private:
+	const unsigned char* m_bytes;
+	size_t m_size;
+	size_t m_offset = 0;
+	bool m_failed = false;
+};
+
+#endif // WORLDSNAPSHOT_H_
@@ -1,7 +1,10 @@
 #include "GameController.h"
+#include "StudentWorld.h"
+#include "Replay.h"
 #include <iostream>
 #include <fstream>
 #include <string>
+#include <cstdlib>
 using namespace std;
 
 #ifdef _WIN32
@@ -26,12 +29,15 @@ bool is_directory(string path)
 
 const string assetDirectory = "/Users/connorethan/Downloads/SuperPeachSisters/DerivedData/SuperPeachSisters/Build/Products/Debug/Assets";
 
-class GameWorld;
-
-GameWorld* createStudentWorld(string assetPath = "");
+  // Options (GLUT takes its own from the same list): the replay options in Replay.h, where -p hands the game to
+  // the keyboard once the recording ends
 
 int main(int argc, char* argv[])
 {
+	ReplayOptions options;
+	for (int i = 1; i < argc; i++)
+		options.parse(i, argc, argv);
+
     string assetPath = assetDirectory;
     if (!assetPath.empty())
     {
@@ -53,6 +59,26 @@ int main(int argc, char* argv[])
 		}
 	}
 
-	GameWorld* gw = createStudentWorld(assetPath);
+	Replay replay;
+	if (!options.playPath.empty() && !replay.load(options.playPath))
+	{
+		cout << "Cannot read replay " << options.playPath << endl;
+		return 1;
+	}
+	ReplayPlayer player(replay, options.startTick);
+	ReplayRecorder recorder;
+
+	  // the game deletes the world once its window closes, but the recording outlives it
+	StudentWorld* gw = new StudentWorld(assetPath);
+	if (!options.playPath.empty())
+		gw->setReplayPlayer(&player);
+	if (!options.recordPath.empty())
+		gw->setReplayRecorder(&recorder);
 	Game().run(argc, argv, gw, "Super Peach Sisters");
+
+	if (!options.recordPath.empty() && !recorder.save(options.recordPath))
+	{
+		cout << "Cannot write replay " << options.recordPath << endl;
+		return 1;
+	}
 }